@@ -1,6 +1,10 @@
 TARGET = 1
-SOURCES += gridwidget.cpp aio.cpp
-HEADERS += defs.h gridwidget.h
+include(game.pri)
+include(render.pri)
+SOURCES += gridwidget.cpp toastoverlay.cpp simthread.cpp spriteloader.cpp terminal.cpp savefile.cpp aio.cpp
+HEADERS += gridwidget.h toastoverlay.h simthread.h spriteloader.h terminal.h triplebuffer.h spscqueue.h savefile.h
+# The sprites are built into the executable
+RESOURCES += assets.qrc
 QT += core gui widgets
 CONFIG += debug
 win32 {
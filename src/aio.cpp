@@ -1,26 +1,51 @@
 #include <QApplication>
+#include <QScreen>
 #include "gridwidget.h"
+#include "spriteloader.h"
 #include "defs.h"
+#include "rng.h"
+#include "mappedfile.h"
+#include "savefile.h"
+#include "trace.h"
+#include "terminal.h"
 #include <iostream>
 #include <cstdio>
 #include <cstdlib>
-#include <sstream>
 
 #ifdef _WIN32
 #include <windows.h>
-#define CLEAR_COMMAND "cls"
-#else
-#define CLEAR_COMMAND "clear"
 #endif
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <random>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <utility>
 #include <vector>
-#include <fstream>
-#include <regex>
-#include <thread>
 
 using namespace std;
 
+// Seed of the next match. Starts at --seed (or a random value) and moves on
+// after every match, so a printed seed passed back via --seed replays it.
+uint64_t nextMatchSeed = 0;
+// Shown on the menu once a match has been played, so its seed stays on
+// screen after the match window closes
+string lastMatchLine;
+
+// Arena and other knobs for every match, --grid sets the size
+SimParams matchParams;
+
+// Where the session goes next
+enum class Screen {
+    Menu,
+    Shop,
+    Match,
+    Exit
+};
+
 void initdata(datastorage &data){
     data.auraxp = 0;
     data.boughtblocks = 0;
@@ -28,274 +53,313 @@ void initdata(datastorage &data){
     data.level = 0;
 }
 
-bool configExists(){
-    ifstream file("config.txt");
-    return file.good();
-}
+// A message under the menu or shop that goes away on its own; keys are
+// taken as usual meanwhile
+struct StatusLine {
+    string text;
+    chrono::steady_clock::time_point until;
 
-const string BASE64_ALPHABET = 
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-    "abcdefghijklmnopqrstuvwxyz"
-    "0123456789+/";
+    void show(const string &message, int seconds){
+        text = message;
+        until = chrono::steady_clock::now() + chrono::seconds(seconds);
+    }
+};
+
+// Recordings of the most recent matches kept in replays/
+const size_t KEPT_REPLAYS = 20;
 
-string base64_encode(const string& input) {
-    using namespace std;
-    string encoded;
-    int val = 0, valb = -6;
-    for (char c : input) {
-        val = (val << 8) + static_cast<uint8_t>(c);
-        valb += 8;
-        while (valb >= 0) {
-            encoded.push_back(BASE64_ALPHABET[(val >> valb) & 0x3F]);
-            valb -= 6;
+// Deletes all but the newest keep recordings in dir
+void pruneReplays(const filesystem::path &dir, size_t keep){
+    std::error_code ec;
+    vector<pair<filesystem::file_time_type, filesystem::path>> replays;
+    for(const filesystem::directory_entry &entry : filesystem::directory_iterator(dir, ec)){
+        if(entry.is_regular_file(ec) && entry.path().extension() == ".rpl"){
+            replays.emplace_back(entry.last_write_time(ec), entry.path());
         }
     }
-    if (valb > -6) {
-        encoded.push_back(BASE64_ALPHABET[((val << 8) >> (valb + 8)) & 0x3F]);
+    if(replays.size() <= keep){
+        return;
     }
-    while (encoded.size() % 4) {
-        encoded.push_back('=');
+    sort(replays.begin(), replays.end());
+    for(size_t i = 0; i + keep < replays.size(); i++){
+        filesystem::remove(replays[i].second, ec);
     }
-    return encoded;
 }
 
-string base64_decode(const string& encoded) {
-    string decoded;
-    vector<int> decode_table(256, -1);
-    for (size_t i = 0; i < BASE64_ALPHABET.size(); ++i) {
-        decode_table[BASE64_ALPHABET[i]] = i;
-    }
-    int val = 0, valb = -8;
-    for (size_t i = 0; i < encoded.size(); ++i) {
-        if (encoded[i] == '=') break;
-        if (decode_table[encoded[i]] == -1) continue;
-        val = (val << 6) + decode_table[encoded[i]];
-        valb += 6;
-        if (valb >= 0) {
-            decoded.push_back(static_cast<char>((val >> valb) & 0xFF));
-            valb -= 8;
-        }
-    }
-    return decoded;
-}
+// Shown when save.dat could not be written; the game goes on with the
+// progress in memory
+const string SAVE_FAILED = "Could not write save.dat; progress since the last save is lost on exit.";
 
-bool configisValid(){
-    ifstream fin("config.txt");
-    string s;
-    fin >> s;
-    if(s.length() % 4 != 0){
-        return false;
+// Saves after a purchase and says whether that worked
+void savePurchase(StatusLine &status, const datastorage &data, const string &done, int seconds){
+    if(writeSave(data)){
+        status.show(done, seconds);
     }
-    regex base64_regex("^(?:[A-Za-z00-9+/]{4})*(?:[A-Za-z0-9+/]{2}==|[A-Za-z0-9+/]{3}=)?$");
-    bool isok = regex_match(s, base64_regex);
-    if(isok){
-        string dc = base64_decode(s);
-        int sc = 0;
-        for(char c : dc){
-            if(c == ';') sc++;
-        }
-        if(sc == 3) return true;
-        else return false;
-    }
-    return false;
-}
-
-vector<string> _split(const string& input){
-    vector<string> parts;
-    stringstream ss(input);
-    string part;
-    while(getline(ss, part, ';')){
-        parts.push_back(part);
+    else{
+        status.show(SAVE_FAILED, 5);
     }
-    return parts;
-}
-
-void readconfig(datastorage &data){
-    ifstream fin("config.txt");
-    string s;
-    fin >> s;
-    string decoded = base64_decode(s);
-    auto splited = _split(decoded);
-    int size = splited.size();
-    splited.reserve(size);
-    data.auraxp = stoull(splited[0]);
-    data.boughtblocks = stoull(splited[1]);
-    data.boughthp = stoull(splited[2]);
-    data.level = stoull(splited[3]);
-    fin.close();
 }
 
-void writeconfig(datastorage &data){
-    ofstream fout("config.txt");
-    string s = to_string(data.auraxp) + ';' + to_string(data.boughtblocks) + ';' + to_string(data.boughthp) + ';' + to_string(data.level);
-    string encoded = base64_encode(s);
-    fout << encoded;
-    fout.close();
+vector<string> prmain(){
+    return {
+        "========================================",
+        "          🐶 Save The Dogs 🐶          ",
+        "========================================",
+        "Description: This is a game made by team X-Pathfinder",
+        "How To Play:",
+        "1. Draw a box(any shape) with the limited blocks in a limited time",
+        "   to prevent the dogs from getting stung by the bees.",
+        "2. Get XP Aura after each win, you can buy things using XP Aura in the Market.",
+        "",
+        lastMatchLine,
+        "Press S Key for start, P Key for Shop, E Key for exit",
+    };
 }
 
-void prmain(){
-    system(CLEAR_COMMAND);
-    cout << "========================================\n";
-    cout << "          🐶 Save The Dogs 🐶          \n";
-    cout << "========================================\n";
-    cout << "Description: This is a game made by team X-Pathfinder\n";
-    cout << "How To Play:\n";
-    cout << "1. Draw a box(any shape) with the limited blocks in a limited time to prevent the dogs from getting stung by the bees.\n";
-    cout << "2. Get XP Aura after each win, you can buy things using XP Aura in the Market.\n";
-    cout << "\n";
-    cout << "\n";
-    cout << "Press S Key for start, P Key for Shop, E Key for exit\n";
-    cout << "Remember to press ENTER after you input your choice.\n";
+vector<string> displayshop(const datastorage &data){
+    return {
+        " ░▒▓███████▓▒░▒▓█▓▒░░▒▓█▓▒░░▒▓██████▓▒░░▒▓███████▓▒░  ",
+        "░▒▓█▓▒░      ░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░ ",
+        "░▒▓█▓▒░      ░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░ ",
+        " ░▒▓██████▓▒░░▒▓████████▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓███████▓▒░  ",
+        "       ░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░        ",
+        "       ░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░        ",
+        "░▒▓███████▓▒░░▒▓█▓▒░░▒▓█▓▒░░▒▓██████▓▒░░▒▓█▓▒░        ",
+        "",
+        "AuraXP: " + to_string(data.auraxp),
+        "Bought Extra Blocks: " + to_string(data.boughtblocks),
+        "Bought Extra HP: " + to_string(data.boughthp),
+        "Current Level: " + to_string(data.level),
+        "Items: ",
+        "1. 4 Extra Block（1000 AuraXP）",
+        "2. 2 Extra Hp（400 AuraXP）",
+        "3. Level Up 1 Level（75 AuraXP）",
+        "R: Return to main menu",
+        "E: Exit",
+        "Please Enter your choice: ",
+    };
 }
 
-void displayshop(datastorage data){
-    system(CLEAR_COMMAND);
-    cout << " ░▒▓███████▓▒░▒▓█▓▒░░▒▓█▓▒░░▒▓██████▓▒░░▒▓███████▓▒░  \n";
-    cout << "░▒▓█▓▒░      ░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░ \n";
-    cout << "░▒▓█▓▒░      ░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░ \n";
-    cout << " ░▒▓██████▓▒░░▒▓████████▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓███████▓▒░  \n";
-    cout << "       ░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░        \n";
-    cout << "       ░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░░▒▓█▓▒░▒▓█▓▒░        \n";
-    cout << "░▒▓███████▓▒░░▒▓█▓▒░░▒▓█▓▒░░▒▓██████▓▒░░▒▓█▓▒░        \n";
-    cout << "\n";
-    cout << "AuraXP: " << data.auraxp << "\nBought Extra Blocks: " << data.boughtblocks << "\nBought Extra HP: " << data.boughthp << "\nCurrent Level: " << data.level << '\n';
-    cout << "Items: " << endl;
-    cout << "1. 4 Extra Block（1000 AuraXP）" << endl;  
-    cout << "2. 2 Extra Hp（400 AuraXP）" << endl;
-    cout << "3. Level Up 1 Level（75 AuraXP）" << endl;
-    cout << "R: Return to main menu" << endl;
-    cout << "E: Exit" << endl;
-    cout << "Please Enter your choice: ";
-    return;
+// Shows the screen, and the status under it while it lasts, until a key
+// is pressed. Input running out counts as E.
+char readchoice(Terminal &terminal, const vector<string> &screen, const StatusLine &status){
+    while(true){
+        vector<string> frame = screen;
+        int timeoutMs = -1;
+        const auto now = chrono::steady_clock::now();
+        if(now < status.until){
+            frame.push_back("");
+            frame.push_back(status.text);
+            timeoutMs = static_cast<int>(chrono::duration_cast<chrono::milliseconds>(status.until - now).count()) + 1;
+        }
+        terminal.draw(frame);
+        char key;
+        if(terminal.readKey(key, timeoutMs)){
+            return key;
+        }
+        if(terminal.closed()){
+            return 'E';
+        }
+    }
 }
 
-int main();
-
-void gameshop(datastorage &data){
-    displayshop(data);
-    char c;
+Screen gameshop(Terminal &terminal, StatusLine &status, datastorage &data){
+    const string tooPoor = "Sorry, but you don't have enough AuraXP to buy this item.";
     while(true){
-        cin >> c;
+        const char c = readchoice(terminal, displayshop(data), status);
         if(c == '1'){
             if(data.auraxp >= 1000) {
                 data.auraxp -= 1000;
                 data.boughtblocks += 4;
-                writeconfig(data);
-                cout << "Purchase successful! You bought 5 Extra Block.\n";
-                this_thread::sleep_for(chrono::seconds(1));
+                savePurchase(status, data, "Purchase successful! You bought 4 Extra Block.", 1);
             } else {
-                cout << "Sorry, but you don't have enough AuraXP to buy this item.\nSleeping 3.0 seconds...\n";
-                this_thread::sleep_for(chrono::seconds(3));
+                status.show(tooPoor, 3);
             }
-            system(CLEAR_COMMAND);
-            displayshop(data);
-            continue;
         }
         else if(c == '2'){
             if(data.auraxp >= 400) {
                 data.auraxp -= 400;
                 data.boughthp += 2;
-                writeconfig(data);
-                cout << "Purchase successful! You bought 2 Extra HP.\n";
+                savePurchase(status, data, "Purchase successful! You bought 2 Extra HP.", 3);
             } else {
-                cout << "Sorry, but you don't have enough AuraXP to buy this item.\nSleeping 3.0 seconds...\n";
+                status.show(tooPoor, 3);
             }
-            this_thread::sleep_for(chrono::seconds(3));
-            system(CLEAR_COMMAND);
-            displayshop(data);
-            continue;
         }
         else if(c == '3'){
             if(data.auraxp >= 75) {
                 data.auraxp -= 75;
                 data.level++;
-                writeconfig(data);
-                cout << "Purchase successful! You leveled up!\n";
+                savePurchase(status, data, "Purchase successful! You leveled up!", 3);
             } else {
-                cout << "Sorry, but you don't have enough AuraXP to buy this item.\nSleeping 3.0 seconds...\n";
+                status.show(tooPoor, 3);
             }
-            this_thread::sleep_for(chrono::seconds(3));
-            system(CLEAR_COMMAND);
-            displayshop(data);
-            continue;
         }
         else if(c == 'R' || c == 'r'){
-            main();
-            return;
+            return Screen::Menu;
         }
         else if(c == 'E' || c == 'e'){
-            return;
+            return Screen::Exit;
         }
         else{
-            cout << "Invalid Input: " << c << "\nSleeping 1.0 seconds";
-            this_thread::sleep_for(chrono::seconds(1));
-            system(CLEAR_COMMAND);
-            displayshop(data);
-            continue;
+            status.show(string("Invalid Input: ") + c, 1);
         }
     }
-    return;
 }
 
-void gamemain(datastorage &data){
-    data.blocks = data.boughtblocks + (rand() % 61 + 20);
-    data.current_hp = data.boughthp + (rand() % 11 + 10);
-    int argc = 1;
-    char *argv[] = {(char*)"aio", nullptr};
-    QApplication a(argc, argv);
-    GridWidget w(data);
-    w.show();
-    a.exec();
-    writeconfig(data);
-    system(CLEAR_COMMAND);
-    main();
+Screen gamemain(QApplication &app, Terminal &terminal, StatusLine &status, unique_ptr<GridWidget> &window,
+               const shared_future<SpriteImages> &sprites, datastorage &data){
+    const uint64_t seed = nextMatchSeed;
+    splitmix64(nextMatchSeed);
+    terminal.clear();
+    cout << "Match seed: " << seed << endl;
+    Rng rolls(seed);
+    data.blocks = data.boughtblocks + rolls.range(20, 80);
+    data.current_hp = data.boughthp + rolls.range(10, 20);
+    // The window, its sprites and its view stay between matches
+    if(window){
+        window->newMatch(seed);
+    }
+    else{
+        window.reset(new GridWidget(data, seed, matchParams));
+        window->setSprites(sprites.get());
+    }
+    window->show();
+    app.exec();
+    // Whatever was typed at the console during the match is not a menu choice
+    terminal.discardInput();
+    const bool saved = writeSave(data);
+    lastMatchLine = "Last match seed: " + to_string(seed) + " (--seed " + to_string(seed) + " plays it again)";
+    // Keep the last few recordings so a bug report can come with the exact match
+    std::error_code ec;
+    filesystem::create_directories("replays", ec);
+    if(window->recording().save("replays/" + to_string(seed) + ".rpl")){
+        pruneReplays("replays", KEPT_REPLAYS);
+    }
+    else{
+        status.show("Could not save the replay of match " + to_string(seed) + ".", 3);
+    }
+    if(!saved){
+        status.show(SAVE_FAILED, 5);
+    }
+    return Screen::Menu;
 }
 
-int main(){
-#ifdef _WIN32
-    SetConsoleTitleA("Save The Dogs");
-    SetConsoleOutputCP(CP_UTF8);
-#else
-    printf("\033]0;Save The Dogs\007"); 
-#endif
-    prmain();
-    char key;
-    bool choice;
+Screen menumain(Terminal &terminal, StatusLine &status){
     while(true){
-        cin >> key;
+        const char key = readchoice(terminal, prmain(), status);
         if(key == 'S' || key == 's'){
-            choice = true;
-            break;
+            return Screen::Match;
         }
         else if(key == 'P' || key == 'p'){
-            choice = false;
-            break;
+            return Screen::Shop;
         }
         else if(key == 'E' || key == 'e'){
-            system(CLEAR_COMMAND);
-            return 0;
+            return Screen::Exit;
         }
         else{
-            cout << "Invalid choice: " << key << '\n';
+            status.show(string("Invalid choice: ") + key, 1);
         }
     }
+}
+
+// Menu, shop and matches for as long as the player keeps going. The save
+// file is read once and the match window is made once, up front and on the
+// first match, so a round costs the same however many came before it.
+// The sprites decode meanwhile, done long before the first match starts.
+int sessionmain(QApplication &app){
+    const shared_future<SpriteImages> sprites = loadSprites(app.primaryScreen()->devicePixelRatio());
+#ifdef _WIN32
+    SetConsoleTitleA("Save The Dogs");
+    SetConsoleOutputCP(CP_UTF8);
+#else
+    printf("\033]0;Save The Dogs\007"); 
+#endif
     datastorage data;
     initdata(data);
-    if(!configExists()){
-        writeconfig(data);
+    SaveStatus status = loadSave(data);
+    // Progress that cannot be read is never written over
+    if(status == SaveStatus::Newer){
+        cerr << "save.dat was written by a newer version of the game; update to keep playing with it.\n";
+        return 1;
     }
-    if(!configisValid()){
-        cout << "Invalid config, regenerating...\n";
-        this_thread::sleep_for(chrono::seconds(3));
-        remove("config.txt");
-        writeconfig(data);
+    if(status == SaveStatus::Corrupt && !setAsideSave()){
+        cerr << "save.dat is damaged and could not be renamed to save.dat.bad; move it away to start over.\n";
+        return 1;
     }
-    readconfig(data);
-    if(choice){
-        gamemain(data);
+    Terminal terminal;
+    StatusLine statusLine;
+    if(status == SaveStatus::Corrupt){
+        statusLine.show("Invalid save file, kept as save.dat.bad; starting over.", 3);
     }
-    else{
-        gameshop(data);
+    if((status == SaveStatus::Missing || status == SaveStatus::Corrupt) && !writeSave(data)){
+        statusLine.show(SAVE_FAILED, 5);
+    }
+    unique_ptr<GridWidget> window;
+    Screen screen = Screen::Menu;
+    while(screen != Screen::Exit){
+        switch(screen){
+        case Screen::Menu:
+            screen = menumain(terminal, statusLine);
+            break;
+        case Screen::Shop:
+            screen = gameshop(terminal, statusLine, data);
+            break;
+        case Screen::Match:
+            screen = gamemain(app, terminal, statusLine, window, sprites, data);
+            break;
+        case Screen::Exit:
+            break;
+        }
     }
     return 0;
-}
\ No newline at end of file
+}
+
+// Watches a recorded match; nothing is written back to save.dat
+int replaymain(QApplication &app, const string &path, double speed){
+    const shared_future<SpriteImages> sprites = loadSprites(app.primaryScreen()->devicePixelRatio());
+    MappedFile file;
+    ReplayPlayer player;
+    string error = "cannot open file";
+    if(!file.open(path) || !player.load(file.data(), file.size(), error)){
+        cerr << path << ": " << error << '\n';
+        return 1;
+    }
+    datastorage data = player.header().start;
+    GridWidget w(data, player.header().seed, player.header().params);
+    w.setSprites(sprites.get());
+    w.playReplay(&player, speed);
+    w.show();
+    return app.exec();
+}
+
+int main(int argc, char *argv[]){
+    random_device rd;
+    nextMatchSeed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    string replayPath;
+    double speed = 1;
+    for(int i = 1; i < argc; i++){
+        if(!strcmp(argv[i], "--seed") && i + 1 < argc){
+            nextMatchSeed = strtoull(argv[++i], nullptr, 10);
+        }
+        else if(!strcmp(argv[i], "--replay") && i + 1 < argc){
+            replayPath = argv[++i];
+        }
+        else if(!strcmp(argv[i], "--speed") && i + 1 < argc && atof(argv[i + 1]) > 0){
+            speed = atof(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "--grid") && i + 1 < argc &&
+                sscanf(argv[i + 1], "%dx%d", &matchParams.gridCols, &matchParams.gridRows) == 2 &&
+                matchParams.gridCols >= MIN_GRID_COLS && matchParams.gridCols <= MAX_GRID_POINTS &&
+                matchParams.gridRows >= MIN_GRID_ROWS && matchParams.gridRows <= MAX_GRID_POINTS){
+            i++;
+        }
+        else{
+            cerr << "usage: " << argv[0] << " [--seed N] [--grid COLSxROWS] [--replay FILE [--speed X]]\n";
+            return 1;
+        }
+    }
+    QApplication app(argc, argv);
+    int rc = !replayPath.empty() ? replaymain(app, replayPath, speed) : sessionmain(app);
+    traceDump("trace.json");
+    return rc;
+}
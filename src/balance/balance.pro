@@ -0,0 +1,7 @@
+TARGET = balance
+include(../game.pri)
+INCLUDEPATH += $$PWD
+HEADERS += montecarlo.h lineplacement.h
+SOURCES += balancemain.cpp montecarlo.cpp lineplacement.cpp
+CONFIG += console release thread c++17
+CONFIG -= qt app_bundle
\ No newline at end of file
@@ -0,0 +1,197 @@
+// Headless Monte Carlo runner for balance tuning.
+//
+//   balance [--matches N] [--threads N] [--seed N] [--policy none|random|box|wall|fort]
+//           [--blocks N] [--hp N] [--max-seconds N] [--csv FILE] [--record DIR]
+//           [--waves MIN-MAX] [--wave-size N] [--bee-hp MIN-MAX]
+//           [--line-health N] [--line-damage MIN-MAX] [--bee-damage MIN-MAX]
+//           [--dog-damage MIN-MAX] [--xp MIN-MAX] [--stun N] [--survive N]
+//           [--grid COLSxROWS]
+//
+// --blocks and --hp are the bought extras from the shop; every match still
+// rolls its base blocks and HP like the game does. --record DIR saves every
+// match as a replay, e.g. to build a regression set for replaycheck.
+
+#include "lineplacement.h"
+#include "montecarlo.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+bool parseGrid(const char *text, int &cols, int &rows) {
+    return sscanf(text, "%dx%d", &cols, &rows) == 2 &&
+           cols >= MIN_GRID_COLS && cols <= MAX_GRID_POINTS && rows >= MIN_GRID_ROWS && rows <= MAX_GRID_POINTS;
+}
+
+// A single number; "5-8" is refused rather than quietly read as 5
+bool parseValue(const char *text, int &value) {
+    int end = 0;
+    return sscanf(text, "%d%n", &value, &end) == 1 && text[end] == '\0';
+}
+
+bool parseRange(const char *text, int &lo, int &hi) {
+    if (sscanf(text, "%d-%d", &lo, &hi) == 2) return lo <= hi;
+    if (sscanf(text, "%d", &lo) == 1) { hi = lo; return true; }
+    return false;
+}
+
+template <typename T>
+T percentile(vector<T> values, double p) {
+    if (values.empty()) return T();
+    size_t k = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+template <typename T>
+double mean(const vector<T> &values) {
+    if (values.empty()) return 0;
+    double sum = 0;
+    for (T v : values) sum += static_cast<double>(v);
+    return sum / values.size();
+}
+
+void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--matches N] [--threads N] [--seed N] [--policy none|random|box|wall|fort]\n"
+            "          [--blocks N] [--hp N] [--max-seconds N] [--csv FILE] [--record DIR]\n"
+            "          [--waves MIN-MAX] [--wave-size N] [--bee-hp MIN-MAX]\n"
+            "          [--line-health N] [--line-damage MIN-MAX] [--bee-damage MIN-MAX]\n"
+            "          [--dog-damage MIN-MAX] [--xp MIN-MAX] [--stun N] [--survive N]\n"
+            "          [--grid COLSxROWS]\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    MatchConfig config;
+    SimParams &params = config.params;
+    int matches = 1000;
+    int threads = max(1u, thread::hardware_concurrency());
+    uint64_t seed = 1;
+    const char *csvPath = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool ok = value != nullptr;
+        if (ok) {
+            if (!strcmp(arg, "--matches")) matches = atoi(value);
+            else if (!strcmp(arg, "--threads")) threads = atoi(value);
+            else if (!strcmp(arg, "--seed")) seed = strtoull(value, nullptr, 10);
+            else if (!strcmp(arg, "--policy")) config.policy = value;
+            else if (!strcmp(arg, "--blocks")) config.boughtBlocks = strtoull(value, nullptr, 10);
+            else if (!strcmp(arg, "--hp")) config.boughtHp = strtoull(value, nullptr, 10);
+            else if (!strcmp(arg, "--max-seconds")) config.maxSeconds = atoi(value);
+            else if (!strcmp(arg, "--csv")) csvPath = value;
+            else if (!strcmp(arg, "--record")) config.recordDir = value;
+            else if (!strcmp(arg, "--waves")) ok = parseRange(value, params.minWaves, params.maxWaves);
+            else if (!strcmp(arg, "--wave-size")) ok = parseValue(value, params.beesPerWave);
+            else if (!strcmp(arg, "--bee-hp")) ok = parseRange(value, params.beeMinHealth, params.beeMaxHealth);
+            else if (!strcmp(arg, "--line-health")) ok = parseValue(value, params.lineHealth);
+            else if (!strcmp(arg, "--line-damage")) ok = parseRange(value, params.lineMinDamage, params.lineMaxDamage);
+            else if (!strcmp(arg, "--bee-damage")) ok = parseRange(value, params.beeMinDamage, params.beeMaxDamage);
+            else if (!strcmp(arg, "--dog-damage")) ok = parseRange(value, params.dogMinDamage, params.dogMaxDamage);
+            else if (!strcmp(arg, "--xp")) ok = parseRange(value, params.minXp, params.maxXp);
+            else if (!strcmp(arg, "--stun")) ok = parseValue(value, params.stunUpdates);
+            else if (!strcmp(arg, "--survive")) ok = parseValue(value, params.survivalUpdates);
+            else if (!strcmp(arg, "--grid")) ok = parseGrid(value, params.gridCols, params.gridRows);
+            else ok = false;
+        }
+        if (!ok) {
+            usage(argv[0]);
+            return 2;
+        }
+        ++i;
+    }
+    if (matches < 1 || !makeLinePolicy(config.policy)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!params.valid()) {
+        fprintf(stderr, "match parameters out of range: waves up to %d, wave size up to %d,\n"
+                        "other values 0 to %d with MIN <= MAX\n",
+                SimParams::MAX_WAVES, SimParams::MAX_BEES_PER_WAVE, SimParams::MAX_AMOUNT);
+        return 2;
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<MatchOutcome> outcomes = runMatches(config, matches, seed, threads);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    int wins = 0, stung = 0, invalid = 0, cutOff = 0;
+    vector<double> winSeconds;
+    vector<double> lossSeconds;
+    vector<unsigned long long> hpLost;
+    vector<int> xp;
+    for (const MatchOutcome &o : outcomes) {
+        hpLost.push_back(o.hpLost);
+        switch (o.result) {
+        case MatchResult::Victory:
+            wins++;
+            winSeconds.push_back(static_cast<double>(o.ticks) / GameSimulation::TICKS_PER_SECOND);
+            xp.push_back(o.xp);
+            break;
+        case MatchResult::DogStung:
+            stung++;
+            lossSeconds.push_back(static_cast<double>(o.ticks) / GameSimulation::TICKS_PER_SECOND);
+            break;
+        case MatchResult::InvalidHealth: invalid++; break;
+        case MatchResult::Running: cutOff++; break;
+        }
+    }
+
+    printf("Matches:        %d on %d thread(s), seed %llu, policy %s\n", matches, threads,
+           static_cast<unsigned long long>(seed), config.policy.c_str());
+    printf("Elapsed:        %.2f s (%.0f matches/s)\n", seconds, matches / seconds);
+    printf("Win rate:       %.1f%% (%d won, %d stung, %d invalid hp, %d cut off)\n",
+           100.0 * wins / matches, wins, stung, invalid, cutOff);
+    printf("Time to win:    mean %.1f s, p50 %.1f s, p90 %.1f s\n",
+           mean(winSeconds), percentile(winSeconds, 0.5), percentile(winSeconds, 0.9));
+    // Losing policies still differ in how long they hold out
+    printf("Time to sting:  mean %.1f s, p50 %.1f s, p90 %.1f s\n",
+           mean(lossSeconds), percentile(lossSeconds, 0.5), percentile(lossSeconds, 0.9));
+    printf("HP lost:        mean %.2f, p50 %llu, p90 %llu, max %llu\n",
+           mean(hpLost), percentile(hpLost, 0.5), percentile(hpLost, 0.9), percentile(hpLost, 1.0));
+    printf("XP per win:     mean %.1f, min %d, p50 %d, max %d\n",
+           mean(xp), percentile(xp, 0.0), percentile(xp, 0.5), percentile(xp, 1.0));
+
+    // XP histogram over the configured reward range
+    const int BUCKETS = 8;
+    const int span = params.maxXp - params.minXp + 1;
+    vector<int> histogram(BUCKETS, 0);
+    for (int v : xp) {
+        histogram[min(BUCKETS - 1, (v - params.minXp) * BUCKETS / max(span, 1))]++;
+    }
+    for (int b = 0; b < BUCKETS && !xp.empty(); ++b) {
+        int lo = params.minXp + span * b / BUCKETS;
+        int hi = params.minXp + span * (b + 1) / BUCKETS - 1;
+        printf("  %4d-%-4d %6d %s\n", lo, hi, histogram[b],
+               string(60 * histogram[b] / xp.size(), '#').c_str());
+    }
+
+    if (csvPath) {
+        FILE *csv = fopen(csvPath, "w");
+        if (!csv) {
+            fprintf(stderr, "Cannot write %s\n", csvPath);
+            return 1;
+        }
+        fprintf(csv, "match,result,ticks,start_hp,hp_lost,xp\n");
+        for (size_t i = 0; i < outcomes.size(); ++i) {
+            const MatchOutcome &o = outcomes[i];
+            fprintf(csv, "%zu,%d,%lld,%llu,%llu,%d\n", i, static_cast<int>(o.result), o.ticks, o.startHp, o.hpLost, o.xp);
+        }
+        fclose(csv);
+    }
+    traceDump("trace.json");
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "lineplacement.h"
+#include <algorithm>
+
+PlaceResult LinePolicy::place(GameSimulation &sim, SimPoint a, SimPoint b) {
+    const PlaceResult result = sim.placeLine(a, b);
+    if (result == PlaceResult::Placed) {
+        m_placed.push_back(Placement{a, b});
+    }
+    return result;
+}
+
+namespace {
+
+// Lattice cell range covering a pixel span, widened by pad cells
+int toLatticeFloor(int pixel, int spacing, int pad) {
+    return std::max((pixel - MARGIN) / spacing - pad, 0);
+}
+
+int toLatticeCeil(int pixel, int spacing, int pad, int limit) {
+    return std::min((pixel - MARGIN + spacing - 1) / spacing + pad, limit - 1);
+}
+
+class NoLines : public LinePolicy {
+public:
+    void act(GameSimulation &, Rng &) override {}
+};
+
+// Scribbles short lines anywhere, a few per second of game time
+class RandomLines : public LinePolicy {
+public:
+    void act(GameSimulation &sim, Rng &rng) override {
+        if (sim.tick() % GameSimulation::TICKS_PER_SECOND != 0 || rng.range(0, 2) != 0) {
+            return;
+        }
+        SimPoint a{rng.range(0, sim.cols() - 1), rng.range(0, sim.rows() - 1)};
+        SimPoint b{std::min(std::max(a.x + rng.range(-4, 4), 0), sim.cols() - 1),
+                   std::min(std::max(a.y + rng.range(-4, 4), 0), sim.rows() - 1)};
+        place(sim, a, b);
+    }
+};
+
+// Walls the dog in with a rectangle during the countdown
+class BoxAroundDog : public LinePolicy {
+public:
+    BoxAroundDog() : m_done(false) {}
+
+    void act(GameSimulation &sim, Rng &) override {
+        if (m_done) {
+            return;
+        }
+        m_done = true;
+        const int s = sim.spacing();
+        const SimPoint dog = sim.dogPos();
+        const int left = toLatticeFloor(dog.x, s, 1);
+        const int top = toLatticeFloor(dog.y, s, 1);
+        const int right = toLatticeCeil(dog.x + GameSimulation::DOG_SIZE, s, 1, sim.cols());
+        const int bottom = toLatticeCeil(dog.y + GameSimulation::DOG_SIZE, s, 1, sim.rows());
+        // Bees come from the right, so that side goes first
+        place(sim, SimPoint{right, top}, SimPoint{right, bottom});
+        place(sim, SimPoint{left, top}, SimPoint{right, top});
+        place(sim, SimPoint{left, bottom}, SimPoint{right, bottom});
+        place(sim, SimPoint{left, top}, SimPoint{left, bottom});
+    }
+
+private:
+    bool m_done;
+};
+
+// The same box with two more walls outside its right side, a cell apart,
+// and every wall that breaks put back as soon as blocks allow. A line
+// breaks while bees are still pinned on it; the next wall in catches them
+// before they reach the dog.
+class Fort : public LinePolicy {
+public:
+    void act(GameSimulation &sim, Rng &) override {
+        const int s = sim.spacing();
+        const SimPoint dog = sim.dogPos();
+        const int left = toLatticeFloor(dog.x, s, 1);
+        const int top = toLatticeFloor(dog.y, s, 1);
+        const int right = toLatticeCeil(dog.x + GameSimulation::DOG_SIZE, s, 1, sim.cols());
+        const int bottom = toLatticeCeil(dog.y + GameSimulation::DOG_SIZE, s, 1, sim.rows());
+        // Walls still standing are already walled and cost nothing
+        place(sim, SimPoint{right, top}, SimPoint{right, bottom});
+        place(sim, SimPoint{left, top}, SimPoint{right, top});
+        place(sim, SimPoint{left, bottom}, SimPoint{right, bottom});
+        place(sim, SimPoint{left, top}, SimPoint{left, bottom});
+        for (int layer = 1; layer <= 2; layer++) {
+            const int x = std::min(right + layer, sim.cols() - 1);
+            place(sim, SimPoint{x, top}, SimPoint{x, bottom});
+        }
+    }
+};
+
+// One vertical wall between the dog and the incoming bees, topped up
+// whenever the old one breaks and blocks allow
+class WallInFront : public LinePolicy {
+public:
+    void act(GameSimulation &sim, Rng &) override {
+        if (sim.tick() % GameSimulation::TICKS_PER_SECOND != 0) {
+            return;
+        }
+        for (const Line &line : sim.lines()) {
+            if (line.health > 0) {
+                return;
+            }
+        }
+        const int x = toLatticeCeil(sim.dogPos().x + GameSimulation::DOG_SIZE, sim.spacing(), 2, sim.cols());
+        place(sim, SimPoint{x, 0}, SimPoint{x, sim.rows() - 1});
+    }
+};
+
+} // namespace
+
+std::unique_ptr<LinePolicy> makeLinePolicy(const std::string &name) {
+    if (name == "none") return std::unique_ptr<LinePolicy>(new NoLines());
+    if (name == "random") return std::unique_ptr<LinePolicy>(new RandomLines());
+    if (name == "box") return std::unique_ptr<LinePolicy>(new BoxAroundDog());
+    if (name == "wall") return std::unique_ptr<LinePolicy>(new WallInFront());
+    if (name == "fort") return std::unique_ptr<LinePolicy>(new Fort());
+    return nullptr;
+}
@@ -0,0 +1,38 @@
+#ifndef LINEPLACEMENT_H
+#define LINEPLACEMENT_H
+
+#include "gamesimulation.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Stand-in for the player: decides where to draw lines during a headless
+// match. One instance per match, so policies may keep state.
+class LinePolicy {
+public:
+    struct Placement {
+        SimPoint a;
+        SimPoint b;
+    };
+
+    virtual ~LinePolicy() {}
+    // Called before every simulation tick.
+    virtual void act(GameSimulation &sim, Rng &rng) = 0;
+
+    // Lines accepted since clearPlaced(), as asked for, for the replay
+    // recorder (the simulation may have merged them into older lines)
+    const std::vector<Placement> &placed() const { return m_placed; }
+    void clearPlaced() { m_placed.clear(); }
+
+protected:
+    // sim.placeLine(), remembering the lines it accepts
+    PlaceResult place(GameSimulation &sim, SimPoint a, SimPoint b);
+
+private:
+    std::vector<Placement> m_placed;
+};
+
+// "none", "random", "box", "wall" or "fort"; nullptr for an unknown name.
+std::unique_ptr<LinePolicy> makeLinePolicy(const std::string &name);
+
+#endif // LINEPLACEMENT_H
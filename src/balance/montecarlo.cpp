@@ -0,0 +1,78 @@
+#include "montecarlo.h"
+#include "lineplacement.h"
+#include "replay.h"
+#include <thread>
+
+uint64_t matchSeed(uint64_t baseSeed, int index) {
+    // Jump the splitmix64 stream straight to the index'th output
+    uint64_t state = baseSeed + 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(index);
+    return splitmix64(state);
+}
+
+MatchOutcome playMatch(const MatchConfig &config, uint64_t seed) {
+    Rng rolls(seed);
+    datastorage data = {};
+    data.blocks = config.boughtBlocks + rolls.range(20, 80);
+    data.current_hp = config.boughtHp + rolls.range(10, 20);
+
+    MatchOutcome outcome;
+    outcome.startHp = data.current_hp;
+
+    GameSimulation sim(data, seed, config.params);
+    std::unique_ptr<LinePolicy> policy = makeLinePolicy(config.policy);
+    Rng policyRng(~seed);
+    ReplayRecorder recorder;
+    const bool recording = !config.recordDir.empty();
+    if (recording) {
+        recorder.begin(sim);
+    }
+    const long long maxTicks = static_cast<long long>(config.maxSeconds) * GameSimulation::TICKS_PER_SECOND;
+    while (sim.result() == MatchResult::Running && sim.tick() < maxTicks) {
+        if (policy) {
+            policy->act(sim, policyRng);
+            if (recording) {
+                for (const LinePolicy::Placement &p : policy->placed()) {
+                    recorder.placed(sim, p.a, p.b);
+                }
+            }
+            policy->clearPlaced();
+        }
+        sim.step();
+        if (recording) {
+            recorder.ticked(sim);
+        }
+    }
+    if (recording) {
+        recorder.save(config.recordDir + "/" + std::to_string(seed) + ".rpl");
+    }
+
+    outcome.result = sim.result();
+    outcome.ticks = sim.tick();
+    outcome.xp = sim.xpReward();
+    outcome.hpLost = outcome.startHp - data.current_hp;
+    return outcome;
+}
+
+std::vector<MatchOutcome> runMatches(const MatchConfig &config, int count,
+                                     uint64_t baseSeed, int threads) {
+    std::vector<MatchOutcome> outcomes(count);
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    auto worker = [&](int first) {
+        for (int i = first; i < count; i += threads) {
+            outcomes[i] = playMatch(config, matchSeed(baseSeed, i));
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+    return outcomes;
+}
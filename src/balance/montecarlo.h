@@ -0,0 +1,37 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include "gamesimulation.h"
+#include <string>
+#include <vector>
+
+struct MatchConfig {
+    SimParams params;
+    std::string policy = "box";
+    unsigned long long boughtBlocks = 0;
+    unsigned long long boughtHp = 0;
+    int maxSeconds = 3600;  // matches still running after this are cut off
+    std::string recordDir;  // when set, every match is saved there as a replay
+};
+
+struct MatchOutcome {
+    MatchResult result;  // Running if the match hit maxSeconds
+    long long ticks;
+    unsigned long long startHp;
+    unsigned long long hpLost;
+    int xp;
+};
+
+// Seed of match index, independent of how matches are spread over threads
+uint64_t matchSeed(uint64_t baseSeed, int index);
+
+// Rolls blocks and HP and seeds the simulation exactly like gamemain, so a
+// seed reported from the game replays here (minus the player's input).
+MatchOutcome playMatch(const MatchConfig &config, uint64_t seed);
+
+// Plays count matches on the given number of threads. Every worker owns its
+// simulations and generators and writes only its own slots of the result.
+std::vector<MatchOutcome> runMatches(const MatchConfig &config, int count,
+                                     uint64_t baseSeed, int threads);
+
+#endif // MONTECARLO_H
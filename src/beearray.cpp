@@ -0,0 +1,72 @@
+#include "beearray.h"
+
+void BeeArray::clear() {
+    x.clear();
+    y.clear();
+    health.clear();
+    maxHealth.clear();
+    stunnedTime.clear();
+    flags.clear();
+    prevX.clear();
+    prevY.clear();
+    slot.clear();
+    m_slots.clear();
+    m_index.clear();
+}
+
+void BeeArray::reserve(size_t n) {
+    x.reserve(n);
+    y.reserve(n);
+    health.reserve(n);
+    maxHealth.reserve(n);
+    stunnedTime.reserve(n);
+    flags.reserve(n);
+    prevX.reserve(n);
+    prevY.reserve(n);
+    slot.reserve(n);
+    m_slots.reserve(n);
+    m_index.reserve(n);
+}
+
+void BeeArray::push(int px, int py, int hp) {
+    x.push_back(px);
+    y.push_back(py);
+    health.push_back(hp);
+    maxHealth.push_back(hp);
+    stunnedTime.push_back(0);
+    flags.push_back(MOVING);
+    prevX.push_back(px);
+    prevY.push_back(py);
+    const uint32_t s = m_slots.allocate();
+    if (s >= m_index.size()) {
+        m_index.resize(s + 1);
+    }
+    m_index[s] = static_cast<int>(size() - 1);
+    slot.push_back(s);
+}
+
+void BeeArray::remove(size_t i) {
+    const size_t last = size() - 1;
+    m_slots.release(slot[i]);
+    if (i != last) {
+        slot[i] = slot[last];
+        m_index[slot[i]] = static_cast<int>(i);
+        x[i] = x[last];
+        y[i] = y[last];
+        health[i] = health[last];
+        maxHealth[i] = maxHealth[last];
+        stunnedTime[i] = stunnedTime[last];
+        flags[i] = flags[last];
+        prevX[i] = prevX[last];
+        prevY[i] = prevY[last];
+    }
+    x.pop_back();
+    y.pop_back();
+    health.pop_back();
+    maxHealth.pop_back();
+    stunnedTime.pop_back();
+    flags.pop_back();
+    prevX.pop_back();
+    prevY.pop_back();
+    slot.pop_back();
+}
@@ -0,0 +1,47 @@
+#ifndef BEEARRAY_H
+#define BEEARRAY_H
+
+#include "slotallocator.h"
+#include <cstddef>
+#include <vector>
+
+// Bee state as parallel arrays so the movement kernel can stream through
+// positions without dragging the rest of the struct along. Order is not
+// stable: remove() moves the last bee into the freed slot. A handle follows
+// its bee wherever it is moved to.
+struct BeeArray {
+    enum Flags : unsigned char {
+        MOVING = 1,
+        STUNNED = 2,
+        TOUCHING_LINE = 4
+    };
+
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<int> health;
+    std::vector<int> maxHealth;
+    std::vector<int> stunnedTime;
+    std::vector<unsigned char> flags;
+    // Position before the last movement update, to draw bees in between
+    std::vector<int> prevX;
+    std::vector<int> prevY;
+    std::vector<uint32_t> slot;  // handle slot of each bee
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+
+    void clear();
+    void reserve(size_t n);
+    void push(int px, int py, int hp);
+    void remove(size_t i);
+
+    Handle handle(size_t i) const { return m_slots.handle(slot[i]); }
+    // Where the bee is now, -1 once it has been removed
+    int indexOf(Handle h) const { return m_slots.valid(h) ? m_index[h.slot] : -1; }
+
+private:
+    SlotAllocator m_slots;
+    std::vector<int> m_index;  // array index per slot
+};
+
+#endif // BEEARRAY_H
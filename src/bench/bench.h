@@ -0,0 +1,20 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// One reproducible benchmark. setup() builds fresh state for a sample and
+// returns the body that gets timed; the body runs iterations times per sample.
+struct BenchScenario {
+    std::string name;
+    std::string unit;  // what one iteration is, e.g. "tick" or "frame"
+    int iterations;
+    std::function<std::function<void()>()> setup;
+};
+
+void addSimScenarios(std::vector<BenchScenario> &out);
+void addRenderScenarios(std::vector<BenchScenario> &out, const std::string &assetDir);
+
+#endif // BENCH_H
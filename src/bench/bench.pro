@@ -0,0 +1,9 @@
+TARGET = bench
+include(../game.pri)
+include(../render.pri)
+INCLUDEPATH += $$PWD
+HEADERS += bench.h
+SOURCES += benchmain.cpp simscenarios.cpp renderscenarios.cpp
+QT += core gui
+CONFIG += console release
+CONFIG -= app_bundle
\ No newline at end of file
@@ -0,0 +1,184 @@
+// Benchmark suite for the simulation and render paths.
+//
+//   bench [--filter TEXT] [--samples N] [--json FILE] [--assets DIR]
+//         [--compare BASELINE.json] [--threshold PERCENT] [--list]
+//
+// Results are written as JSON; --compare flags every scenario whose median
+// got slower than the baseline by more than the threshold (default 10%)
+// and makes the run exit with status 1.
+
+#include "bench.h"
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct BenchResult {
+    string name;
+    string unit;
+    int iterations;
+    int samples;
+    double median;  // ns per iteration
+    double min;
+    double max;
+};
+
+BenchResult runScenario(const BenchScenario &scenario, int samples) {
+    vector<double> perIteration;
+    for (int s = 0; s < samples; ++s) {
+        function<void()> body = scenario.setup();
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < scenario.iterations; ++i) {
+            body();
+        }
+        auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+        perIteration.push_back(static_cast<double>(elapsed.count()) / scenario.iterations);
+    }
+    sort(perIteration.begin(), perIteration.end());
+
+    BenchResult result;
+    result.name = scenario.name;
+    result.unit = scenario.unit;
+    result.iterations = scenario.iterations;
+    result.samples = samples;
+    result.median = perIteration[perIteration.size() / 2];
+    result.min = perIteration.front();
+    result.max = perIteration.back();
+    return result;
+}
+
+map<string, double> loadBaseline(const char *path) {
+    map<string, double> medians;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "Cannot read baseline %s\n", path);
+        exit(2);
+    }
+    QJsonArray results = QJsonDocument::fromJson(file.readAll()).object().value("results").toArray();
+    for (const QJsonValue &value : results) {
+        QJsonObject entry = value.toObject();
+        medians[entry.value("name").toString().toStdString()] = entry.value("median_ns").toDouble();
+    }
+    return medians;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    string filter;
+    string assetDir = ".";
+    const char *jsonPath = "bench_results.json";
+    const char *baselinePath = nullptr;
+    double threshold = 10.0;
+    int samples = 5;
+    bool listOnly = false;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--filter") && hasValue) filter = argv[++i];
+        else if (!strcmp(argv[i], "--samples") && hasValue) samples = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--json") && hasValue) jsonPath = argv[++i];
+        else if (!strcmp(argv[i], "--assets") && hasValue) assetDir = argv[++i];
+        else if (!strcmp(argv[i], "--compare") && hasValue) baselinePath = argv[++i];
+        else if (!strcmp(argv[i], "--threshold") && hasValue) threshold = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--list")) listOnly = true;
+        else {
+            fprintf(stderr, "usage: %s [--filter TEXT] [--samples N] [--json FILE] [--assets DIR]\n"
+                            "       [--compare BASELINE.json] [--threshold PERCENT] [--list]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Rendering goes to QImage only, no display needed
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    vector<BenchScenario> scenarios;
+    addSimScenarios(scenarios);
+    addRenderScenarios(scenarios, assetDir);
+
+    map<string, double> baseline;
+    if (baselinePath) {
+        baseline = loadBaseline(baselinePath);
+    }
+
+    QJsonArray jsonResults;
+    int regressions = 0;
+    if (!listOnly) {
+        printf("%-36s %14s %14s %10s\n", "scenario", "median ns", "baseline ns", "change");
+    }
+    for (const BenchScenario &scenario : scenarios) {
+        if (!filter.empty() && scenario.name.find(filter) == string::npos) {
+            continue;
+        }
+        if (listOnly) {
+            printf("%s\n", scenario.name.c_str());
+            continue;
+        }
+
+        BenchResult r = runScenario(scenario, samples);
+        QJsonObject entry;
+        entry["name"] = QString::fromStdString(r.name);
+        entry["unit"] = QString::fromStdString(r.unit);
+        entry["iterations"] = r.iterations;
+        entry["samples"] = r.samples;
+        entry["median_ns"] = r.median;
+        entry["min_ns"] = r.min;
+        entry["max_ns"] = r.max;
+
+        auto base = baseline.find(r.name);
+        if (base != baseline.end() && base->second > 0) {
+            double change = (r.median / base->second - 1.0) * 100.0;
+            bool regressed = change > threshold;
+            regressions += regressed;
+            entry["baseline_ns"] = base->second;
+            entry["change_percent"] = change;
+            entry["regressed"] = regressed;
+            printf("%-36s %14.0f %14.0f %+9.1f%%%s\n", r.name.c_str(), r.median, base->second, change,
+                   regressed ? "  REGRESSION" : "");
+        } else {
+            printf("%-36s %14.0f %14s %10s\n", r.name.c_str(), r.median, "-", "-");
+        }
+        jsonResults.append(entry);
+    }
+    if (listOnly) {
+        return 0;
+    }
+
+    QJsonObject root;
+    root["version"] = 1;
+    root["samples"] = samples;
+    root["results"] = jsonResults;
+    if (baselinePath) {
+        root["threshold_percent"] = threshold;
+        root["regressions"] = regressions;
+    }
+    QFile out(jsonPath);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        fprintf(stderr, "Cannot write %s\n", jsonPath);
+        return 2;
+    }
+    out.write(QJsonDocument(root).toJson());
+    printf("\nWrote %s\n", jsonPath);
+
+    if (regressions > 0) {
+        printf("%d scenario(s) regressed by more than %.1f%%\n", regressions, threshold);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "bench.h"
+#include "gamerenderer.h"
+#include "gamesimulation.h"
+#include <QImage>
+#include <QPainter>
+#include <QRegion>
+#include <memory>
+#include <random>
+
+using namespace std;
+
+namespace {
+
+struct Frame {
+    datastorage data;
+    GameSimulation sim;
+    SimSnapshot state;  // what the window would paint from
+    GameRenderer renderer;
+    QImage image;
+    ArenaView view;
+
+    // The image is a window onto the arena, at most 1600x900 like a screen
+    explicit Frame(const SimParams &params)
+        : data{0, 0, 0, 0, 1000000000ULL, 1000000000000ULL}, sim(data, 4242, params),
+          image(min(sim.width(), 1600), min(sim.height(), 900), QImage::Format_ARGB32_Premultiplied) {
+        view.size = image.size();
+    }
+};
+
+// Missing assets would turn every blit into a no-op, so fall back to a
+// solid sprite of a typical source size.
+QPixmap loadSprite(const string &path) {
+    QPixmap pixmap(QString::fromStdString(path));
+    if (pixmap.isNull()) {
+        pixmap = QPixmap(256, 256);
+        pixmap.fill(Qt::yellow);
+    }
+    return pixmap;
+}
+
+shared_ptr<Frame> makeFrame(int bees, int lines, const string &assetDir, const SimParams &params = SimParams()) {
+    auto frame = make_shared<Frame>(params);
+    frame->renderer.sprites().setSource(SpriteCache::Dog, loadSprite(assetDir + "/doghead.png"));
+    frame->renderer.sprites().setSource(SpriteCache::Bee, loadSprite(assetDir + "/bee.png"));
+
+    mt19937 rng(17);
+    uniform_int_distribution<int> xs(0, frame->sim.width() - GameSimulation::BEE_SIZE);
+    uniform_int_distribution<int> ys(MARGIN, frame->sim.height() - GameSimulation::BEE_SIZE);
+    for (int i = 0; i < bees; ++i) {
+        frame->sim.addBee(xs(rng), ys(rng), 20);
+    }
+    uniform_int_distribution<int> cols(0, frame->sim.cols() - 1);
+    uniform_int_distribution<int> rows(0, frame->sim.rows() - 1);
+    uniform_int_distribution<int> reach(-4, 4);
+    for (int i = 0; i < lines; ++i) {
+        const SimPoint a{cols(rng), rows(rng)};
+        // Short lines on big arenas, like a player would draw
+        const SimPoint b = frame->sim.cols() == GRID_COLS
+            ? SimPoint{cols(rng), rows(rng)}
+            : SimPoint{min(max(a.x + reach(rng), 0), frame->sim.cols() - 1), min(max(a.y + reach(rng), 0), frame->sim.rows() - 1)};
+        frame->sim.placeLine(a, b);
+    }
+    frame->state.capture(frame->sim);
+    return frame;
+}
+
+// Same work as GridWidget::paintEvent for a full-window repaint
+BenchScenario fullFrameScenario(const string &name, int bees, int lines, const string &assetDir,
+                                const SimParams &params = SimParams()) {
+    BenchScenario s;
+    s.name = name;
+    s.unit = "frame";
+    s.iterations = 50;
+    s.setup = [bees, lines, assetDir, params]() -> function<void()> {
+        auto frame = makeFrame(bees, lines, assetDir, params);
+        return [frame]() {
+            QPainter p(&frame->image);
+            frame->renderer.paint(p, frame->image.rect(), 1.0, frame->view, frame->state, 1.0, vector<QPoint>());
+        };
+    };
+    return s;
+}
+
+SimParams largeArena() {
+    SimParams params;
+    params.gridCols = 1000;
+    params.gridRows = 1000;
+    return params;
+}
+
+// Repaint limited to the bee rectangles, as after an ordinary tick
+BenchScenario beeRegionScenario(const string &name, int bees, int lines, const string &assetDir) {
+    BenchScenario s;
+    s.name = name;
+    s.unit = "frame";
+    s.iterations = 50;
+    s.setup = [bees, lines, assetDir]() -> function<void()> {
+        auto frame = makeFrame(bees, lines, assetDir);
+        QRegion region;
+        const BeeArray &all = frame->sim.bees();
+        for (size_t i = 0; i < all.size(); i++) {
+            region += GameRenderer::beeRect(all.x[i], all.y[i]);
+        }
+        return [frame, region]() {
+            QPainter p(&frame->image);
+            p.setClipRegion(region);
+            frame->renderer.paint(p, region.boundingRect(), 1.0, frame->view, frame->state, 1.0, vector<QPoint>());
+        };
+    };
+    return s;
+}
+
+} // namespace
+
+void addRenderScenarios(vector<BenchScenario> &out, const string &assetDir) {
+    out.push_back(fullFrameScenario("render_full_bees25_lines20", 25, 20, assetDir));
+    out.push_back(fullFrameScenario("render_full_bees500_lines200", 500, 200, assetDir));
+    out.push_back(beeRegionScenario("render_beeregion_bees25_lines20", 25, 20, assetDir));
+    out.push_back(beeRegionScenario("render_beeregion_bees500_lines200", 500, 200, assetDir));
+    out.push_back(fullFrameScenario("render_full_arena1000_bees20000_lines5000", 20000, 5000, assetDir, largeArena()));
+}
@@ -0,0 +1,262 @@
+#include "bench.h"
+#include "beearray.h"
+#include "gamesimulation.h"
+#include "movebees.h"
+#include "segmentbox.h"
+#include "flowfield.h"
+#include <memory>
+#include <random>
+
+using namespace std;
+
+namespace {
+
+// The simulation keeps a reference to its save data, so both live together
+struct Match {
+    datastorage data;
+    GameSimulation sim;
+
+    Match()
+        : data{0, 0, 0, 0, 1000000000ULL, 1000000000000ULL}, sim(data, 4242) {
+        // Burn the countdown so every timed tick moves bees
+        sim.step(10 * GameSimulation::TICKS_PER_SECOND);
+    }
+};
+
+// Bees that survive the whole sample: huge health, spread over the arena
+void addBees(Match &match, int count, mt19937 &rng) {
+    uniform_int_distribution<int> xs(0, match.sim.width() + 100);
+    uniform_int_distribution<int> ys(MARGIN, match.sim.height() - GameSimulation::BEE_SIZE);
+    for (int i = 0; i < count; ++i) {
+        match.sim.addBee(xs(rng), ys(rng), 1 << 30);
+    }
+}
+
+// Short random walls, like a player scribbling
+void addRandomLines(Match &match, int count, mt19937 &rng) {
+    uniform_int_distribution<int> cols(0, GRID_COLS - 1);
+    uniform_int_distribution<int> rows(0, GRID_ROWS - 1);
+    uniform_int_distribution<int> reach(-6, 6);
+    for (int i = 0; i < count; ++i) {
+        SimPoint a{cols(rng), rows(rng)};
+        SimPoint b{min(max(a.x + reach(rng), 0), GRID_COLS - 1), min(max(a.y + reach(rng), 0), GRID_ROWS - 1)};
+        match.sim.placeLine(a, b);
+    }
+}
+
+// Every lattice edge as its own line
+void addLattice(Match &match) {
+    for (int y = 0; y < GRID_ROWS; ++y) {
+        for (int x = 0; x < GRID_COLS; ++x) {
+            if (x + 1 < GRID_COLS) match.sim.placeLine(SimPoint{x, y}, SimPoint{x + 1, y});
+            if (y + 1 < GRID_ROWS) match.sim.placeLine(SimPoint{x, y}, SimPoint{x, y + 1});
+        }
+    }
+}
+
+BenchScenario simScenario(const string &name, int bees, int lines, bool lattice) {
+    BenchScenario s;
+    s.name = name;
+    s.unit = "bee update";
+    s.iterations = 100;
+    s.setup = [bees, lines, lattice]() -> function<void()> {
+        auto match = make_shared<Match>();
+        mt19937 rng(17);
+        addBees(*match, bees, rng);
+        if (lattice) {
+            addLattice(*match);
+        } else {
+            addRandomLines(*match, lines, rng);
+        }
+        return [match]() { match->sim.step(GameSimulation::TICKS_PER_SECOND); };
+    };
+    return s;
+}
+
+// A long match where bees keep breaking lines and new ones keep coming;
+// destroyed lines must not pile up and slow every later tick
+BenchScenario lineChurnScenario(const string &name, int bees, int linesPerSecond) {
+    BenchScenario s;
+    s.name = name;
+    s.unit = "bee update";
+    s.iterations = 100;
+    s.setup = [bees, linesPerSecond]() -> function<void()> {
+        auto match = make_shared<Match>();
+        auto rng = make_shared<mt19937>(23);
+        addBees(*match, bees, *rng);
+        // Five minutes in, well short of the survival win
+        for (int second = 0; second < 300; ++second) {
+            addRandomLines(*match, linesPerSecond, *rng);
+            match->sim.step(GameSimulation::TICKS_PER_SECOND);
+        }
+        return [match, rng, linesPerSecond]() {
+            addRandomLines(*match, linesPerSecond, *rng);
+            match->sim.step(GameSimulation::TICKS_PER_SECOND);
+        };
+    };
+    return s;
+}
+
+void fillBees(BeeArray &bees, size_t count) {
+    mt19937 rng(1234);
+    uniform_int_distribution<int> xs(0, 1591 + 150);
+    uniform_int_distribution<int> ys(0, 799 - 64);
+    uniform_int_distribution<int> roll(0, 9);
+    bees.clear();
+    bees.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        bees.push(xs(rng), ys(rng), 20);
+        if (roll(rng) == 0) {
+            bees.flags[i] = BeeArray::STUNNED | BeeArray::TOUCHING_LINE;
+        }
+    }
+}
+
+BenchScenario moveScenario(const string &name, size_t count, bool scalar) {
+    BenchScenario s;
+    s.name = name;
+    s.unit = "tick";
+    s.iterations = static_cast<int>(2000000 / count);
+    s.setup = [count, scalar]() -> function<void()> {
+        auto bees = make_shared<BeeArray>();
+        fillBees(*bees, count);
+        BeeMoveParams params;
+        params.midX = 1591 / 2;
+        params.spacing = 33;
+        auto targetX = make_shared<vector<int>>(count, 300);
+        auto targetY = make_shared<vector<int>>(count, 350);
+        return [bees, targetX, targetY, params, scalar]() {
+            if (scalar) {
+                moveBeesScalar(bees->x.data(), bees->y.data(), targetX->data(), targetY->data(),
+                               bees->flags.data(), bees->size(), params);
+            } else {
+                moveBees(bees->x.data(), bees->y.data(), targetX->data(), targetY->data(),
+                         bees->flags.data(), bees->size(), params);
+            }
+        };
+    };
+    return s;
+}
+
+BenchScenario removeScenario(const string &name, size_t count) {
+    BenchScenario s;
+    s.name = name;
+    s.unit = "1% cull";
+    s.iterations = 200;
+    s.setup = [count]() -> function<void()> {
+        auto bees = make_shared<BeeArray>();
+        fillBees(*bees, count);
+        // Kill every 100th bee, then top the array back up
+        return [bees, count]() {
+            for (size_t i = 0; i < bees->size(); i += 100) {
+                bees->remove(i);
+            }
+            while (bees->size() < count) {
+                bees->push(1591, 100, 20);
+            }
+        };
+    };
+    return s;
+}
+
+// One bee box against a packed batch of short lattice lines
+BenchScenario segmentBoxScenario(const string &name, size_t segments, bool batch) {
+    BenchScenario s;
+    s.name = name;
+    s.unit = "1k box tests";
+    s.iterations = 200;
+    s.setup = [segments, batch]() -> function<void()> {
+        auto lines = make_shared<SegmentArray>();
+        mt19937 rng(99);
+        uniform_int_distribution<int> cols(0, GRID_COLS - 1);
+        uniform_int_distribution<int> rows(0, GRID_ROWS - 1);
+        uniform_int_distribution<int> reach(-4, 4);
+        for (size_t i = 0; i < segments; ++i) {
+            int ax = cols(rng), ay = rows(rng);
+            lines->push(static_cast<float>(MARGIN + ax * 33), static_cast<float>(MARGIN + ay * 33),
+                        static_cast<float>(MARGIN + (ax + reach(rng)) * 33), static_cast<float>(MARGIN + (ay + reach(rng)) * 33));
+        }
+        return [lines, batch]() {
+            size_t hits = 0;
+            for (int b = 0; b < 1000; ++b) {
+                const float x = static_cast<float>(b * 37 % 1591), y = static_cast<float>(b * 11 % 735);
+                const Box box{x, y, x + 63, y + 63};
+                if (batch) {
+                    hits += firstSegmentTouchingBox(lines->x1.data(), lines->y1.data(), lines->x2.data(),
+                                                    lines->y2.data(), lines->size(), box);
+                } else {
+                    for (size_t i = 0; i < lines->size(); ++i) {
+                        if (segmentTouchesBox(lines->x1[i], lines->y1[i], lines->x2[i], lines->y2[i], box)) {
+                            hits += i;
+                            break;
+                        }
+                    }
+                }
+            }
+            volatile size_t sink = hits;
+            (void)sink;
+        };
+    };
+    return s;
+}
+
+// Places and destroys one short line among walls already on the lattice;
+// reset is the full rebuild the repair avoids
+BenchScenario flowFieldScenario(const string &name, size_t walls, bool repair) {
+    BenchScenario s;
+    s.name = name;
+    s.unit = repair ? "100 lines" : "100 rebuilds";
+    s.iterations = 200;
+    s.setup = [walls, repair]() -> function<void()> {
+        auto field = make_shared<FlowField>();
+        auto ends = make_shared<vector<int>>();
+        mt19937 rng(5);
+        uniform_int_distribution<int> cols(0, GRID_COLS - 1);
+        uniform_int_distribution<int> rows(0, GRID_ROWS - 1);
+        uniform_int_distribution<int> reach(-4, 4);
+        for (size_t i = 0; i < walls + 100; ++i) {
+            const int ax = cols(rng), ay = rows(rng);
+            ends->push_back(ax);
+            ends->push_back(ay);
+            ends->push_back(min(max(ax + reach(rng), 0), GRID_COLS - 1));
+            ends->push_back(min(max(ay + reach(rng), 0), GRID_ROWS - 1));
+        }
+        field->reset(GRID_COLS, GRID_ROWS, 8, 12);
+        for (size_t i = 0; i < walls; ++i) {
+            const int *e = ends->data() + i * 4;
+            field->addWall(e[0], e[1], e[2], e[3]);
+        }
+        return [field, ends, walls, repair]() {
+            for (size_t i = walls; i < walls + 100; ++i) {
+                const int *e = ends->data() + i * 4;
+                if (repair) {
+                    field->addWall(e[0], e[1], e[2], e[3]);
+                    field->removeWall(e[0], e[1], e[2], e[3]);
+                } else {
+                    field->reset(GRID_COLS, GRID_ROWS, 8, 12);
+                }
+            }
+        };
+    };
+    return s;
+}
+
+} // namespace
+
+void addSimScenarios(vector<BenchScenario> &out) {
+    out.push_back(simScenario("sim_bees100_lines50", 100, 50, false));
+    out.push_back(simScenario("sim_bees500_lines300", 500, 300, false));
+    out.push_back(simScenario("sim_bees2000_lines300", 2000, 300, false));
+    out.push_back(simScenario("sim_bees1000_lattice", 1000, 0, true));
+    out.push_back(lineChurnScenario("sim_line_churn_bees500", 500, 20));
+
+    out.push_back(moveScenario("move_kernel_1k", 1000, false));
+    out.push_back(moveScenario("move_kernel_10k", 10000, false));
+    out.push_back(moveScenario("move_kernel_100k", 100000, false));
+    out.push_back(moveScenario("move_scalar_10k", 10000, true));
+    out.push_back(removeScenario("bee_remove_10k", 10000));
+    out.push_back(segmentBoxScenario("segment_box_batch8", 8, true));
+    out.push_back(segmentBoxScenario("segment_box_scalar8", 8, false));
+    out.push_back(flowFieldScenario("flow_field_repair_lines50", 50, true));
+    out.push_back(flowFieldScenario("flow_field_reset", 0, false));
+}
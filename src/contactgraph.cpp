@@ -0,0 +1,83 @@
+#include "contactgraph.h"
+#include <algorithm>
+
+const std::vector<int> ContactGraph::NO_LINES;
+const std::vector<Handle> ContactGraph::NO_BEES;
+
+namespace {
+
+template <typename T>
+void eraseValue(std::vector<T> &v, const T &value) {
+    auto it = std::find(v.begin(), v.end(), value);
+    if (it != v.end()) {
+        *it = v.back();
+        v.pop_back();
+    }
+}
+
+} // namespace
+
+void ContactGraph::clear() {
+    for (std::vector<int> &lines : m_beeLines) lines.clear();
+    for (std::vector<Handle> &bees : m_lineBees) bees.clear();
+    m_activeLines.clear();
+    std::fill(m_activeSlot.begin(), m_activeSlot.end(), -1);
+}
+
+void ContactGraph::reserve(std::size_t bees, std::size_t lines) {
+    if (m_beeLines.size() < bees) {
+        m_beeLines.resize(bees);
+    }
+    if (m_lineBees.size() < lines) {
+        m_lineBees.resize(lines);
+        m_activeSlot.resize(lines, -1);
+    }
+    m_activeLines.reserve(lines);
+}
+
+void ContactGraph::add(Handle bee, int line) {
+    if (bee.slot >= m_beeLines.size()) {
+        m_beeLines.resize(bee.slot + 1);
+    }
+    if (line >= static_cast<int>(m_lineBees.size())) {
+        m_lineBees.resize(line + 1);
+        m_activeSlot.resize(line + 1, -1);
+    }
+    m_beeLines[bee.slot].push_back(line);
+    m_lineBees[line].push_back(bee);
+    if (m_activeSlot[line] < 0) {
+        m_activeSlot[line] = static_cast<int>(m_activeLines.size());
+        m_activeLines.push_back(line);
+    }
+}
+
+void ContactGraph::unlink(Handle bee, int line) {
+    std::vector<Handle> &bees = m_lineBees[line];
+    eraseValue(bees, bee);
+    if (bees.empty()) {
+        const int slot = m_activeSlot[line];
+        const int moved = m_activeLines.back();
+        m_activeLines[slot] = moved;
+        m_activeSlot[moved] = slot;
+        m_activeLines.pop_back();
+        m_activeSlot[line] = -1;
+    }
+}
+
+void ContactGraph::removeBee(Handle bee) {
+    if (bee.slot >= m_beeLines.size()) {
+        return;
+    }
+    for (int line : m_beeLines[bee.slot]) {
+        unlink(bee, line);
+    }
+    m_beeLines[bee.slot].clear();
+}
+
+const std::vector<int> &ContactGraph::linesOf(Handle bee) const {
+    return bee.slot < m_beeLines.size() ? m_beeLines[bee.slot] : NO_LINES;
+}
+
+const std::vector<Handle> &ContactGraph::beesOf(int line) const {
+    return line < static_cast<int>(m_lineBees.size()) ? m_lineBees[line] : NO_BEES;
+}
@@ -0,0 +1,39 @@
+#ifndef CONTACTGRAPH_H
+#define CONTACTGRAPH_H
+
+#include "slotallocator.h"
+#include <cstddef>
+#include <vector>
+
+// Which stunned bee is pinned against which line. Stunned bees do not move
+// and lines never move, so edges only change when a bee is stunned,
+// released or removed and when a line is placed or destroyed. Bees are
+// handles, so an edge stays with its bee when the bee array is compacted;
+// lines are the owner's line slots.
+class ContactGraph {
+public:
+    void clear();
+    // Room for bee slots below bees and line slots below lines
+    void reserve(std::size_t bees, std::size_t lines);
+
+    void add(Handle bee, int line);
+    // Drops every edge of bee.
+    void removeBee(Handle bee);
+
+    const std::vector<int> &linesOf(Handle bee) const;
+    const std::vector<Handle> &beesOf(int line) const;
+    // Lines with at least one bee on them, in no particular order
+    const std::vector<int> &activeLines() const { return m_activeLines; }
+
+private:
+    std::vector<std::vector<int>> m_beeLines;  // per bee slot
+    std::vector<std::vector<Handle>> m_lineBees;
+    std::vector<int> m_activeLines;
+    std::vector<int> m_activeSlot;  // index in m_activeLines per line, -1 if none
+    static const std::vector<int> NO_LINES;
+    static const std::vector<Handle> NO_BEES;
+
+    void unlink(Handle bee, int line);
+};
+
+#endif // CONTACTGRAPH_H
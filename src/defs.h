@@ -1,6 +1,15 @@
 #ifndef DEFS_H
 #define DEFS_H
 
+// Arena layout. GRID_COLS x GRID_ROWS is the default arena; SimParams picks
+// the size of each match within the limits below.
+const int GRID_COLS = 48;
+const int GRID_ROWS = 24;
+const int MARGIN = 20;
+const int MIN_GRID_COLS = 8;      // room for the dog in the left half
+const int MIN_GRID_ROWS = 5;
+const int MAX_GRID_POINTS = 1000; // per side
+
 struct datastorage {
     unsigned long long auraxp;
     unsigned long long boughtblocks;
@@ -0,0 +1,326 @@
+#include "flowfield.h"
+#include <algorithm>
+
+namespace {
+
+// Direction d + 4 is the opposite of d, so each edge is stored from both
+// ends and enumerated once through directions 0-3
+const int DX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+const int DY[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+inline int stepCost(int dir) {
+    return (dir & 1) ? 14 : 10;
+}
+
+inline int orientation(int ax, int ay, int bx, int by, int cx, int cy) {
+    const long long v = static_cast<long long>(bx - ax) * (cy - ay) - static_cast<long long>(by - ay) * (cx - ax);
+    return (v > 0) - (v < 0);
+}
+
+// c is known to be on the line through a and b
+inline bool withinBounds(int ax, int ay, int bx, int by, int cx, int cy) {
+    return std::min(ax, bx) <= cx && cx <= std::max(ax, bx) &&
+           std::min(ay, by) <= cy && cy <= std::max(ay, by);
+}
+
+// Exact on lattice coordinates; touching at an end counts
+bool segmentsTouch(int ax, int ay, int bx, int by, int cx, int cy, int dx, int dy) {
+    if (std::max(ax, bx) < std::min(cx, dx) || std::max(cx, dx) < std::min(ax, bx) ||
+        std::max(ay, by) < std::min(cy, dy) || std::max(cy, dy) < std::min(ay, by)) {
+        return false;
+    }
+    const int o1 = orientation(ax, ay, bx, by, cx, cy);
+    const int o2 = orientation(ax, ay, bx, by, dx, dy);
+    const int o3 = orientation(cx, cy, dx, dy, ax, ay);
+    const int o4 = orientation(cx, cy, dx, dy, bx, by);
+    if (o1 != o2 && o3 != o4) return true;
+    return (o1 == 0 && withinBounds(ax, ay, bx, by, cx, cy)) ||
+           (o2 == 0 && withinBounds(ax, ay, bx, by, dx, dy)) ||
+           (o3 == 0 && withinBounds(cx, cy, dx, dy, ax, ay)) ||
+           (o4 == 0 && withinBounds(cx, cy, dx, dy, bx, by));
+}
+
+inline long long floorDiv(long long a, long long b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// Narrows [lo, hi] to the x with k*x + q >= 0
+void clipSpan(long long k, long long q, int &lo, int &hi) {
+    if (k > 0) {
+        lo = static_cast<int>(std::max<long long>(lo, -floorDiv(q, k)));
+    } else if (k < 0) {
+        hi = static_cast<int>(std::min<long long>(hi, floorDiv(q, -k)));
+    } else if (q < 0) {
+        hi = lo - 1;
+    }
+}
+
+} // namespace
+
+const int FlowField::UNREACHABLE;
+
+void FlowField::reset(int cols, int rows, int goalX, int goalY) {
+    m_cols = cols;
+    m_rows = rows;
+    m_goalX = goalX;
+    m_goalY = goalY;
+    const size_t nodes = static_cast<size_t>(cols) * rows;
+    m_dist.assign(nodes, UNREACHABLE);
+    m_next.assign(nodes, -1);
+    m_blocked.assign(nodes * 8, 0);
+    m_sightBlocked.assign(nodes, 0);
+    m_state.assign(nodes, 0);
+    m_touched.clear();
+
+    push(index(goalX, goalY), 0);
+    propagate();
+    for (size_t node = 0; node < nodes; node++) {
+        chooseNext(static_cast<int>(node));
+    }
+}
+
+void FlowField::addWall(int ax, int ay, int bx, int by) {
+    changeWall(ax, ay, bx, by, 1);
+    raise();
+}
+
+void FlowField::removeWall(int ax, int ay, int bx, int by) {
+    changeWall(ax, ay, bx, by, -1);
+    lower();
+}
+
+bool FlowField::waypoint(int x, int y, int &nextX, int &nextY) const {
+    const int node = index(x, y);
+    const int next = m_next[node];
+    if (m_sightBlocked[node] == 0 || next < 0) {
+        return false;
+    }
+    nextX = next % m_cols;
+    nextY = next / m_cols;
+    return true;
+}
+
+int FlowField::neighbour(int node, int dir) const {
+    const int x = node % m_cols + DX[dir];
+    const int y = node / m_cols + DY[dir];
+    return (x >= 0 && x < m_cols && y >= 0 && y < m_rows) ? index(x, y) : -1;
+}
+
+void FlowField::changeWall(int ax, int ay, int bx, int by, int delta) {
+    // Collect the edges that open or close; edges other walls still block
+    // do not change anything
+    m_edges.clear();
+    const int left = std::max(std::min(ax, bx) - 1, 0);
+    const int right = std::min(std::max(ax, bx) + 1, m_cols - 1);
+    const int top = std::max(std::min(ay, by) - 1, 0);
+    const int bottom = std::min(std::max(ay, by) + 1, m_rows - 1);
+    for (int y = top; y <= bottom; y++) {
+        for (int x = left; x <= right; x++) {
+            const int u = index(x, y);
+            for (int d = 0; d < 4; d++) {
+                const int v = neighbour(u, d);
+                if (v < 0 || !segmentsTouch(x, y, x + DX[d], y + DY[d], ax, ay, bx, by)) {
+                    continue;
+                }
+                uint16_t &forward = m_blocked[u * 8 + d];
+                uint16_t &backward = m_blocked[v * 8 + d + 4];
+                if ((delta > 0 && forward == 0) || (delta < 0 && forward == 1)) {
+                    m_edges.push_back(u * 8 + d);
+                }
+                forward = static_cast<uint16_t>(forward + delta);
+                backward = static_cast<uint16_t>(backward + delta);
+            }
+        }
+    }
+
+    updateSight(ax, ay, bx, by, delta);
+}
+
+void FlowField::updateSight(int ax, int ay, int bx, int by, int delta) {
+    // Points whose straight line to the goal runs into the wall lie in the
+    // wedge from the goal through the wall's ends, on the far side of the
+    // wall. All three bounds are linear in x, so each row has one span of
+    // candidates. A wall in line with the goal has no wedge; scan it all.
+    const long long dax = ax - m_goalX, day = ay - m_goalY;
+    const long long dbx = bx - m_goalX, dby = by - m_goalY;
+    const long long ex = bx - ax, ey = by - ay;
+    const long long turn = dax * dby - day * dbx;
+    const long long goalSide = ex * (m_goalY - ay) - ey * (m_goalX - ax);
+    const int s = (turn > 0) - (turn < 0);
+    const int g = (goalSide > 0) - (goalSide < 0);
+    for (int y = 0; y < m_rows; y++) {
+        int lo = 0;
+        int hi = m_cols - 1;
+        if (s != 0) {
+            const long long dy = y - m_goalY;
+            clipSpan(-day * s, (dax * dy + day * m_goalX) * s, lo, hi);
+            clipSpan(dby * s, -(m_goalX * dby + dy * dbx) * s, lo, hi);
+            clipSpan(ey * g, -(ex * (y - ay) + ey * ax) * g, lo, hi);
+        }
+        for (int x = lo; x <= hi; x++) {
+            if (segmentsTouch(x, y, m_goalX, m_goalY, ax, ay, bx, by)) {
+                uint16_t &sight = m_sightBlocked[index(x, y)];
+                sight = static_cast<uint16_t>(sight + delta);
+            }
+        }
+    }
+}
+
+void FlowField::push(int node, int dist) {
+    m_dist[node] = dist;
+    if (dist >= static_cast<int>(m_buckets.size())) {
+        m_buckets.resize(dist + 1);
+    }
+    m_buckets[dist].push_back(node);
+    m_queued++;
+    m_lowest = std::min(m_lowest, dist);
+    m_touched.push_back(node);
+}
+
+void FlowField::propagate() {
+    // Dijkstra from whatever is queued. Costs are small integers, so the
+    // queue is one bucket per distance; stale entries are skipped
+    while (m_queued > 0) {
+        const int dist = m_lowest;
+        // Room for the longest step, so pushes below never move this bucket;
+        // steps cost at least 10, so nothing lands in it meanwhile either
+        if (m_buckets.size() < static_cast<size_t>(dist) + 15) {
+            m_buckets.resize(dist + 15);
+        }
+        std::vector<int> &bucket = m_buckets[dist];
+        for (int u : bucket) {
+            m_queued--;
+            if (m_dist[u] != dist) {
+                continue;
+            }
+            const int x = u % m_cols;
+            const int y = u / m_cols;
+            for (int d = 0; d < 8; d++) {
+                const int nx = x + DX[d];
+                const int ny = y + DY[d];
+                if (nx < 0 || nx >= m_cols || ny < 0 || ny >= m_rows || m_blocked[u * 8 + d]) {
+                    continue;
+                }
+                const int v = index(nx, ny);
+                if (dist + stepCost(d) < m_dist[v]) {
+                    push(v, dist + stepCost(d));
+                }
+            }
+        }
+        bucket.clear();
+        while (m_queued > 0 && m_buckets[m_lowest].empty()) {
+            m_lowest++;
+        }
+    }
+    m_lowest = UNREACHABLE;
+}
+
+void FlowField::chooseNext(int node) {
+    // The first neighbour on a shortest path, in direction order, so the
+    // field looks the same however it was built
+    m_next[node] = -1;
+    const int dist = m_dist[node];
+    if (dist == 0 || dist == UNREACHABLE) {
+        return;
+    }
+    for (int d = 0; d < 8; d++) {
+        const int v = neighbour(node, d);
+        if (v >= 0 && !m_blocked[node * 8 + d] && m_dist[v] != UNREACHABLE && m_dist[v] + stepCost(d) == dist) {
+            m_next[node] = v;
+            return;
+        }
+    }
+}
+
+void FlowField::raise() {
+    // A closed edge only matters to the nodes whose path ran through it and
+    // to everything routed through those: the subtrees below them
+    m_touched.clear();
+    m_affected.clear();
+    for (int e : m_edges) {
+        const int u = e / 8;
+        const int v = neighbour(u, e % 8);
+        if (m_next[u] == v && !m_state[u]) { m_state[u] = 1; m_affected.push_back(u); }
+        if (m_next[v] == u && !m_state[v]) { m_state[v] = 1; m_affected.push_back(v); }
+    }
+    for (size_t i = 0; i < m_affected.size(); i++) {
+        const int u = m_affected[i];
+        for (int d = 0; d < 8; d++) {
+            const int v = neighbour(u, d);
+            if (v >= 0 && !m_state[v] && m_next[v] == u) {
+                m_state[v] = 1;
+                m_affected.push_back(v);
+            }
+        }
+    }
+    if (m_affected.empty()) {
+        return;
+    }
+
+    // Forget the affected distances, then reseed them from their unaffected
+    // neighbours and let Dijkstra fill in the rest
+    for (int node : m_affected) {
+        m_dist[node] = UNREACHABLE;
+    }
+    for (int node : m_affected) {
+        int best = UNREACHABLE;
+        for (int d = 0; d < 8; d++) {
+            const int v = neighbour(node, d);
+            if (v >= 0 && !m_blocked[node * 8 + d] && m_dist[v] != UNREACHABLE) {
+                best = std::min(best, m_dist[v] + stepCost(d));
+            }
+        }
+        if (best != UNREACHABLE) {
+            push(node, best);
+        }
+    }
+    propagate();
+
+    for (int node : m_affected) {
+        chooseNext(node);
+        m_state[node] = 0;
+    }
+}
+
+void FlowField::lower() {
+    // An opened edge can only shorten paths; relax across it both ways and
+    // spread the improvement
+    m_touched.clear();
+    for (int e : m_edges) {
+        const int u = e / 8;
+        const int d = e % 8;
+        const int v = neighbour(u, d);
+        if (m_dist[u] != UNREACHABLE && m_dist[u] + stepCost(d) < m_dist[v]) {
+            push(v, m_dist[u] + stepCost(d));
+        }
+        if (m_dist[v] != UNREACHABLE && m_dist[v] + stepCost(d) < m_dist[u]) {
+            push(u, m_dist[v] + stepCost(d));
+        }
+    }
+    propagate();
+
+    // Changed nodes, their neighbours and the opened edges' ends may now
+    // prefer another step
+    m_affected.clear();
+    auto mark = [this](int node) {
+        if (!m_state[node]) {
+            m_state[node] = 1;
+            m_affected.push_back(node);
+        }
+    };
+    for (int node : m_touched) {
+        mark(node);
+        for (int d = 0; d < 8; d++) {
+            const int v = neighbour(node, d);
+            if (v >= 0) mark(v);
+        }
+    }
+    for (int e : m_edges) {
+        mark(e / 8);
+        mark(neighbour(e / 8, e % 8));
+    }
+    for (int node : m_affected) {
+        chooseNext(node);
+        m_state[node] = 0;
+    }
+}
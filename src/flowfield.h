@@ -0,0 +1,60 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Shortest paths from every lattice point to one goal point, walking the
+// eight lattice neighbours (straight steps cost 10, diagonal ones 14). A wall
+// blocks every lattice edge it touches. Adding or removing a wall repairs
+// only the part of the field whose paths it changes.
+class FlowField {
+public:
+    static const int UNREACHABLE = INT32_MAX;
+
+    void reset(int cols, int rows, int goalX, int goalY);
+
+    // Wall endpoints are lattice points. Walls may overlap; an edge stays
+    // blocked until every wall across it is gone.
+    void addWall(int ax, int ay, int bx, int by);
+    void removeWall(int ax, int ay, int bx, int by);
+
+    int distance(int x, int y) const { return m_dist[index(x, y)]; }
+
+    // The lattice neighbour one step closer to the goal, for a walker at
+    // (x, y). False when there is nothing to route around: the straight line
+    // to the goal is clear, the goal cannot be reached, or (x, y) is the goal.
+    bool waypoint(int x, int y, int &nextX, int &nextY) const;
+
+private:
+    int m_cols = 0;
+    int m_rows = 0;
+    int m_goalX = 0;
+    int m_goalY = 0;
+    std::vector<int> m_dist;
+    std::vector<int> m_next;              // neighbour on the path, -1 if none
+    std::vector<uint16_t> m_blocked;      // walls across each edge, node*8 + direction
+    std::vector<uint16_t> m_sightBlocked; // walls across the straight line to the goal
+
+    // Repair scratch
+    std::vector<std::vector<int>> m_buckets;  // queued nodes by distance
+    size_t m_queued = 0;
+    int m_lowest = UNREACHABLE;
+    std::vector<int> m_edges;                 // node*8 + direction
+    std::vector<int> m_touched;               // nodes whose distance was set
+    std::vector<int> m_affected;
+    std::vector<unsigned char> m_state;       // 1 while in m_affected
+
+    int index(int x, int y) const { return y * m_cols + x; }
+    int neighbour(int node, int dir) const;
+    void changeWall(int ax, int ay, int bx, int by, int delta);
+    void updateSight(int ax, int ay, int bx, int by, int delta);
+    void push(int node, int dist);
+    void propagate();
+    void chooseNext(int node);
+    void raise();
+    void lower();
+};
+
+#endif // FLOWFIELD_H
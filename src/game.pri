@@ -0,0 +1,16 @@
+# Headless game core, shared by the game and the benchmark targets
+INCLUDEPATH += $$PWD
+HEADERS += $$PWD/defs.h $$PWD/gamesimulation.h $$PWD/spatialgrid.h $$PWD/beearray.h $$PWD/movebees.h $$PWD/rng.h $$PWD/replay.h $$PWD/mappedfile.h $$PWD/scheduler.h $$PWD/trace.h $$PWD/segmentbox.h $$PWD/contactgraph.h $$PWD/slotallocator.h $$PWD/flowfield.h $$PWD/wallmap.h $$PWD/simsnapshot.h
+SOURCES += $$PWD/gamesimulation.cpp $$PWD/spatialgrid.cpp $$PWD/beearray.cpp $$PWD/movebees.cpp $$PWD/replay.cpp $$PWD/mappedfile.cpp $$PWD/scheduler.cpp $$PWD/trace.cpp $$PWD/segmentbox.cpp $$PWD/contactgraph.cpp $$PWD/slotallocator.cpp $$PWD/flowfield.cpp $$PWD/wallmap.cpp $$PWD/simsnapshot.cpp
+
+# Matches must play out the same in every build for replays to hold, so
+# a multiply and an add are never fused into one FMA: the scalar paths and
+# the SIMD kernels would round differently. MSVC only fuses with /fp:contract.
+!msvc {
+    QMAKE_CXXFLAGS += -ffp-contract=off
+}
+
+# qmake CONFIG+=trace: per-phase tick/paint timing, see trace.h
+trace {
+    DEFINES += GAME_TRACE
+}
@@ -0,0 +1,171 @@
+#include "gamerenderer.h"
+#include <QtMath>
+#include <algorithm>
+
+QRect ArenaView::toArena(const QRect &screen) const {
+    const QPointF topLeft = toArena(QPointF(screen.topLeft()));
+    const QPointF bottomRight = toArena(QPointF(screen.right() + 1, screen.bottom() + 1));
+    return QRect(QPoint(qFloor(topLeft.x()), qFloor(topLeft.y())),
+                 QPoint(qCeil(bottomRight.x()) - 1, qCeil(bottomRight.y()) - 1));
+}
+
+QRect ArenaView::toScreen(const QRect &arena) const {
+    const QPointF topLeft = toScreen(QPointF(arena.topLeft()));
+    const QPointF bottomRight = toScreen(QPointF(arena.right() + 1, arena.bottom() + 1));
+    return QRect(QPoint(qFloor(topLeft.x()), qFloor(topLeft.y())),
+                 QPoint(qCeil(bottomRight.x()) - 1, qCeil(bottomRight.y()) - 1));
+}
+
+GameRenderer::GameRenderer()
+    : m_backgroundSpacing(0) {
+}
+
+void GameRenderer::invalidateBackground() {
+    m_background = QPixmap();
+}
+
+QPoint GameRenderer::beePos(const BeeArray &bees, size_t i, qreal beeBlend) {
+    return QPoint(bees.prevX[i] + qRound((bees.x[i] - bees.prevX[i]) * beeBlend),
+                  bees.prevY[i] + qRound((bees.y[i] - bees.prevY[i]) * beeBlend));
+}
+
+QRect GameRenderer::beeRect(int x, int y) {
+    // Sprite plus the health bar above it, padded for the antialiased pen
+    return QRect(x - 2, y - 12, 64 + 4, 64 + 14);
+}
+
+QRect GameRenderer::lineRect(const SimSnapshot &state, const Line &line) {
+    const SimPoint p1 = state.toPixel(line.a);
+    const SimPoint p2 = state.toPixel(line.b);
+    QRect bounds = QRect(QPoint(p1.x, p1.y), QPoint(p2.x, p2.y)).normalized();
+    QPoint midPoint = bounds.center();
+    QRect healthBar(midPoint.x() - 10, midPoint.y() - 15, 20, 5);
+    return bounds.united(healthBar).adjusted(-LINE_WIDTH - 2, -LINE_WIDTH - 2, LINE_WIDTH + 2, LINE_WIDTH + 2);
+}
+
+QRect GameRenderer::selectionRect(const std::vector<QPoint> &selectedPoints) {
+    if (selectedPoints.empty()) {
+        return QRect();
+    }
+    QRect bounds(selectedPoints.front(), selectedPoints.back());
+    return bounds.normalized().adjusted(-POINT_RADIUS - 3, -POINT_RADIUS - 3, POINT_RADIUS + 3, POINT_RADIUS + 3);
+}
+
+void GameRenderer::rebuildBackground(const SimSnapshot &state, const ArenaView &view, qreal dpr) {
+    const int SPACING = state.spacing;
+    m_background = QPixmap(view.size * dpr);
+    m_background.setDevicePixelRatio(dpr);
+    m_backgroundView = view;
+    m_backgroundSpacing = SPACING;
+
+    QPainter p(&m_background);
+    p.fillRect(QRect(QPoint(0, 0), view.size), OUTSIDE_COLOR);
+    p.setRenderHints(QPainter::Antialiasing);
+    p.scale(view.zoom, view.zoom);
+    p.translate(-view.origin);
+
+    // Background
+    p.fillRect(QRect(0, 0, state.width, state.height), BG_COLOR);
+
+    // Grid points on screen, unless zoomed out so far they would merge
+    if (SPACING * view.zoom < MIN_DOT_SPACING) {
+        return;
+    }
+    const QRect visible = view.toArena(QRect(QPoint(0, 0), view.size));
+    const int left = std::max((visible.left() - MARGIN - POINT_RADIUS) / SPACING, 0);
+    const int top = std::max((visible.top() - MARGIN - POINT_RADIUS) / SPACING, 0);
+    const int right = std::min((visible.right() - MARGIN + POINT_RADIUS) / SPACING + 1, state.cols - 1);
+    const int bottom = std::min((visible.bottom() - MARGIN + POINT_RADIUS) / SPACING + 1, state.rows - 1);
+    m_dots.clear();
+    for (int y = top; y <= bottom; ++y) {
+        for (int x = left; x <= right; ++x) {
+            m_dots.push_back(QPointF(MARGIN + x * SPACING, MARGIN + y * SPACING));
+        }
+    }
+    // One round pen point per dot, drawn in a single batch
+    p.setPen(QPen(GRID_COLOR, POINT_RADIUS * 2 + 1, Qt::SolidLine, Qt::RoundCap));
+    p.drawPoints(m_dots.data(), static_cast<int>(m_dots.size()));
+}
+
+void GameRenderer::paint(QPainter &p, const QRect &screenDirty, qreal dpr, const ArenaView &view,
+                         const SimSnapshot &state, qreal beeBlend, const std::vector<QPoint> &selectedPoints) {
+    if (m_background.isNull() || m_backgroundSpacing != state.spacing ||
+        m_background.devicePixelRatioF() != dpr || m_backgroundView != view) {
+        rebuildBackground(state, view, dpr);
+    }
+    
+    p.drawPixmap(0, 0, m_background);
+    p.setRenderHints(QPainter::Antialiasing);
+
+    // Everything else is drawn in arena pixels and culled against the
+    // dirty part of the view
+    p.scale(view.zoom, view.zoom);
+    p.translate(-view.origin);
+    const QRect dirty = view.toArena(screenDirty);
+    const qreal spriteDpr = dpr * view.zoom;
+
+    // Lines with health bars
+    for (const Line &line : state.lines) {
+        if (line.health > 0 && dirty.intersects(lineRect(state, line))) {
+            const SimPoint a = state.toPixel(line.a);
+            const SimPoint b = state.toPixel(line.b);
+            QPoint p1(a.x, a.y);
+            QPoint p2(b.x, b.y);
+            p.setPen(QPen(LINE_COLOR, LINE_WIDTH));
+            p.drawLine(p1, p2);
+            
+            QPoint midPoint = (p1 + p2) / 2;
+            p.setPen(Qt::black);
+            p.drawRect(midPoint.x() - 10, midPoint.y() - 15, 20, 5);
+            p.fillRect(midPoint.x() - 10, midPoint.y() - 15, (line.health * 20) / 20, 5, Qt::green);
+        }
+    }
+
+    // Selected points and temporary lines
+    p.setPen(SELECT_COLOR);
+    p.setBrush(SELECT_COLOR);
+    if (!selectedPoints.empty() && dirty.intersects(selectionRect(selectedPoints))) {
+        p.drawEllipse(selectedPoints[0], POINT_RADIUS+1, POINT_RADIUS+1);
+        if (selectedPoints.size() == 2) {
+            p.drawEllipse(selectedPoints[1], POINT_RADIUS+1, POINT_RADIUS+1);
+            p.setPen(QPen(SELECT_COLOR, LINE_WIDTH));
+            p.drawLine(selectedPoints[0], selectedPoints[1]);
+        }
+    }
+
+    // Dog and bees, drawn from pre-scaled sprites
+    const SimPoint dogPos = state.dogPos;
+    const QSize dogSize = SpriteCache::drawSize(SpriteCache::Dog);
+    if (dirty.intersects(QRect(QPoint(dogPos.x, dogPos.y), dogSize))) {
+        p.drawPixmap(dogPos.x, dogPos.y, m_sprites.pixmap(SpriteCache::Dog, dogSize, spriteDpr));
+    }
+    
+    const BeeArray &bees = state.bees;
+    const QPixmap beeSprite = m_sprites.pixmap(SpriteCache::Bee, SpriteCache::drawSize(SpriteCache::Bee), spriteDpr);
+    const QRectF beeSource(0, 0, beeSprite.width(), beeSprite.height());
+    m_beeFragments.clear();
+    m_healthBarFrames.clear();
+    m_healthBarFills.clear();
+    for (size_t i = 0; i < bees.size(); i++) {
+        const QPoint pos = beePos(bees, i, beeBlend);
+        if (!dirty.intersects(beeRect(pos.x(), pos.y()))) {
+            continue;
+        }
+        // Fragments are positioned by their centre
+        m_beeFragments.push_back(QPainter::PixmapFragment::create(
+            QPointF(pos.x() + 32, pos.y() + 32), beeSource, 1 / spriteDpr, 1 / spriteDpr));
+        
+        int healthWidth = (bees.health[i] * 64) / bees.maxHealth[i];
+        m_healthBarFrames.push_back(QRect(pos.x(), pos.y() - 10, 64, 5));
+        m_healthBarFills.push_back(QRect(pos.x(), pos.y() - 10, healthWidth, 5));
+    }
+    p.drawPixmapFragments(m_beeFragments.data(), static_cast<int>(m_beeFragments.size()), beeSprite);
+    
+    // Bee health bars, one pass for the frames and one for the fill
+    p.setPen(Qt::black);
+    p.setBrush(Qt::NoBrush);
+    p.drawRects(m_healthBarFrames.data(), static_cast<int>(m_healthBarFrames.size()));
+    p.setPen(Qt::NoPen);
+    p.setBrush(Qt::red);
+    p.drawRects(m_healthBarFills.data(), static_cast<int>(m_healthBarFills.size()));
+}
@@ -0,0 +1,80 @@
+#ifndef GAMERENDERER_H
+#define GAMERENDERER_H
+
+#include "simsnapshot.h"
+#include "spritecache.h"
+#include <QPainter>
+#include <QPixmap>
+#include <QPoint>
+#include <QPointF>
+#include <QRect>
+#include <QSize>
+#include <vector>
+
+// Drawing constants
+const int POINT_RADIUS = 3;
+const int LINE_WIDTH = 2;
+const QColor GRID_COLOR = Qt::blue;
+const QColor SELECT_COLOR = Qt::red;
+const QColor LINE_COLOR = Qt::darkGreen;
+const QColor BG_COLOR = Qt::white;
+const QColor OUTSIDE_COLOR = Qt::lightGray;
+const int MIN_DOT_SPACING = 6;  // screen pixels; closer than that the dots are left out
+
+// The part of the arena on screen: arena pixel origin sits at the widget's
+// top-left corner and one arena pixel is zoom widget pixels wide.
+struct ArenaView {
+    QPointF origin;
+    qreal zoom = 1;
+    QSize size;  // widget size
+
+    QPointF toArena(const QPointF &screen) const { return origin + screen / zoom; }
+    QPointF toScreen(const QPointF &arena) const { return (arena - origin) * zoom; }
+    // Smallest whole-pixel rectangles covering r
+    QRect toArena(const QRect &screen) const;
+    QRect toScreen(const QRect &arena) const;
+
+    bool operator==(const ArenaView &o) const { return origin == o.origin && zoom == o.zoom && size == o.size; }
+    bool operator!=(const ArenaView &o) const { return !(*this == o); }
+};
+
+// Paints the visible part of a simulation state onto any QPainter, the game
+// window or an offscreen QImage alike.
+class GameRenderer {
+public:
+    GameRenderer();
+
+    SpriteCache &sprites() { return m_sprites; }
+    void invalidateBackground();
+
+    // Paints everything overlapping dirty, in widget pixels. The painter is
+    // expected to be clipped to (at least) that rectangle already.
+    // beeBlend goes from 0 (bees where they were before the last movement
+    // update) to 1 (where they are now).
+    void paint(QPainter &p, const QRect &dirty, qreal dpr, const ArenaView &view, const SimSnapshot &state,
+               qreal beeBlend, const std::vector<QPoint> &selectedPoints);
+
+    // Where bee i is drawn for a given beeBlend, in arena pixels
+    static QPoint beePos(const BeeArray &bees, size_t i, qreal beeBlend);
+
+    // Areas covered by one item in arena pixels, used to compute dirty regions
+    static QRect beeRect(int x, int y);
+    static QRect lineRect(const SimSnapshot &state, const Line &line);
+    static QRect selectionRect(const std::vector<QPoint> &selectedPoints);
+
+private:
+    SpriteCache m_sprites;
+    QPixmap m_background;  // background and grid dots of the view
+    ArenaView m_backgroundView;
+    int m_backgroundSpacing;
+
+    // Per-frame batches, kept around so painting does not allocate
+    std::vector<QPainter::PixmapFragment> m_beeFragments;
+    std::vector<QRect> m_healthBarFrames;
+    std::vector<QRect> m_healthBarFills;
+    std::vector<QPointF> m_dots;
+
+    void rebuildBackground(const SimSnapshot &state, const ArenaView &view, qreal dpr);
+};
+
+#endif // GAMERENDERER_H
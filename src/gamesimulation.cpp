@@ -0,0 +1,636 @@
+#include "gamesimulation.h"
+#include "movebees.h"
+#include "segmentbox.h"
+#include "trace.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+// Pools reserved up front; matches with more bees or lines than this grow them
+const long long MAX_RESERVED_BEES = 1 << 16;
+const long long MAX_RESERVED_LINES = 1 << 16;
+
+size_t reserveSize(long long wanted, long long limit) {
+    return static_cast<size_t>(std::min(std::max(wanted, 0LL), limit));
+}
+
+// FNV-1a, one 64-bit value at a time
+struct StateHasher {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    void add(uint64_t v) { h = (h ^ v) * 0x100000001B3ULL; }
+};
+
+bool boxesIntersect(SimPoint a, int aSize, SimPoint b, int bSize) {
+    return a.x < b.x + bSize && b.x < a.x + aSize &&
+           a.y < b.y + bSize && b.y < a.y + aSize;
+}
+
+} // namespace
+
+bool SimParams::valid() const {
+    auto inRange = [](int lo, int hi, int max) { return lo >= 0 && lo <= hi && hi <= max; };
+    return inRange(countdownSeconds, countdownSeconds, MAX_COUNTDOWN_SECONDS) &&
+           inRange(minWaves, maxWaves, MAX_WAVES) &&
+           inRange(beesPerWave, beesPerWave, MAX_BEES_PER_WAVE) &&
+           inRange(beeMinHealth, beeMaxHealth, MAX_AMOUNT) &&
+           inRange(lineHealth, lineHealth, MAX_AMOUNT) &&
+           inRange(lineMinDamage, lineMaxDamage, MAX_AMOUNT) &&
+           inRange(beeMinDamage, beeMaxDamage, MAX_AMOUNT) &&
+           inRange(dogMinDamage, dogMaxDamage, MAX_AMOUNT) &&
+           inRange(stunUpdates, stunUpdates, MAX_AMOUNT) &&
+           inRange(survivalUpdates, survivalUpdates, MAX_AMOUNT) &&
+           inRange(minXp, maxXp, MAX_AMOUNT) &&
+           gridCols >= MIN_GRID_COLS && gridCols <= MAX_GRID_POINTS &&
+           gridRows >= MIN_GRID_ROWS && gridRows <= MAX_GRID_POINTS;
+}
+
+GameSimulation::GameSimulation(datastorage &gameData, uint64_t seed, const SimParams &params)
+    : m_gameData(gameData), m_params(params), m_seed(seed), m_rng(seed) {
+    m_params.gridCols = std::min(std::max(m_params.gridCols, MIN_GRID_COLS), MAX_GRID_POINTS);
+    m_params.gridRows = std::min(std::max(m_params.gridRows, MIN_GRID_ROWS), MAX_GRID_POINTS);
+
+    // Spacing is what the default arena got in the old fixed 1600 px
+    // window; larger arenas are larger, not denser
+    const int INITIAL_WINDOW_SIZE = 1600;
+    const float ASPECT_RATIO = 1.0f;
+    const int CELL_WIDTH = (INITIAL_WINDOW_SIZE - 2*MARGIN) / (GRID_COLS - 1);
+    const int CELL_HEIGHT = (INITIAL_WINDOW_SIZE*ASPECT_RATIO - 2*MARGIN) / (GRID_ROWS - 1);
+    m_spacing = std::min(CELL_WIDTH, static_cast<int>(CELL_HEIGHT/ASPECT_RATIO));
+    m_width = MARGIN*2 + (cols()-1)*m_spacing;
+    m_height = MARGIN*2 + (rows()-1)*m_spacing;
+
+    // Euclidean length in grid units, rounded up
+    m_blockCost.resize(static_cast<size_t>(cols()) * rows());
+    for (int dx = 0; dx < cols(); dx++) {
+        for (int dy = 0; dy < rows(); dy++) {
+            m_blockCost[dx * rows() + dy] = static_cast<uint16_t>(ceil(sqrt(double(dx * dx + dy * dy))));
+        }
+    }
+
+    reset();
+}
+
+void GameSimulation::reset() {
+    m_rng.reseed(m_seed);
+    m_tick = 0;
+    m_countdownEndTick = static_cast<long long>(m_params.countdownSeconds) * TICKS_PER_SECOND;
+    m_schedule.clear();
+    m_schedule.schedule(m_countdownEndTick, EVENT_COUNTDOWN_END);
+    m_totalWaves = roll(m_params.minWaves, m_params.maxWaves);
+    m_currentWave = 0;
+    m_survivalTimer = 0;
+    m_result = MatchResult::Running;
+    m_xpReward = 0;
+
+    // Pools sized for the busiest match these parameters allow, so
+    // spawning and placing do not allocate once a match is running. Every
+    // line costs a block, so there are never more lines than starting blocks
+    const size_t beeCapacity = reserveSize(static_cast<long long>(m_params.maxWaves) * m_params.beesPerWave,
+                                           MAX_RESERVED_BEES);
+    const size_t lineCapacity = static_cast<size_t>(
+        std::min<unsigned long long>(m_gameData.blocks, MAX_RESERVED_LINES));
+    m_bees.clear();
+    m_bees.reserve(beeCapacity);
+    m_lines.clear();
+    m_lines.reserve(lineCapacity);
+    m_lineSlots.clear();
+    m_lineSlots.reserve(lineCapacity);
+    m_lineSerial.clear();
+    m_lineSerial.reserve(lineCapacity);
+    m_linesPlaced = 0;
+    m_lineSegments.clear();
+    m_lineSegments.reserve(lineCapacity);
+    m_lineGrid.reset(cols() - 1, rows() - 1, m_spacing, MARGIN, MARGIN);
+    m_walls.reset(cols(), rows());
+    m_contacts.clear();
+    m_contacts.reserve(beeCapacity, lineCapacity);
+
+    // Random dog position
+    m_dogPos = SimPoint{
+        MARGIN + roll(0, m_width/2 - DOG_SIZE - 1),
+        MARGIN + roll(0, m_height - DOG_SIZE - 1)
+    };
+    const SimPoint goal = nearestLattice(m_dogPos);
+    m_flow.reset(cols(), rows(), goal.x, goal.y);
+}
+
+void GameSimulation::reset(uint64_t seed) {
+    m_seed = seed;
+    reset();
+}
+
+int GameSimulation::roll(int lo, int hi) {
+    return m_rng.range(lo, hi);
+}
+
+int GameSimulation::countdownSeconds() const {
+    const long long left = std::max(0LL, m_countdownEndTick - m_tick);
+    return static_cast<int>((left + TICKS_PER_SECOND - 1) / TICKS_PER_SECOND);
+}
+
+SimPoint GameSimulation::toPixel(SimPoint gridPoint) const {
+    return SimPoint{MARGIN + gridPoint.x*m_spacing, MARGIN + gridPoint.y*m_spacing};
+}
+
+SimPoint GameSimulation::toLattice(SimPoint pixel) const {
+    return SimPoint{(pixel.x - MARGIN) / m_spacing, (pixel.y - MARGIN) / m_spacing};
+}
+
+SimPoint GameSimulation::nearestLattice(SimPoint pixel) const {
+    const int x = (std::max(pixel.x - MARGIN, 0) + m_spacing / 2) / m_spacing;
+    const int y = (std::max(pixel.y - MARGIN, 0) + m_spacing / 2) / m_spacing;
+    return SimPoint{std::min(x, cols() - 1), std::min(y, rows() - 1)};
+}
+
+uint64_t GameSimulation::stateHash() const {
+    StateHasher hasher;
+    hasher.add(static_cast<uint64_t>(m_tick));
+    hasher.add(static_cast<uint64_t>(m_result));
+    hasher.add(m_gameData.blocks);
+    hasher.add(m_gameData.current_hp);
+    hasher.add(static_cast<uint64_t>(m_currentWave));
+    hasher.add(static_cast<uint64_t>(m_survivalTimer));
+    for (size_t i = 0; i < m_bees.size(); i++) {
+        hasher.add(static_cast<uint32_t>(m_bees.x[i]));
+        hasher.add(static_cast<uint32_t>(m_bees.y[i]));
+        hasher.add(static_cast<uint32_t>(m_bees.health[i]));
+        hasher.add(static_cast<uint32_t>(m_bees.stunnedTime[i]) | static_cast<uint64_t>(m_bees.flags[i]) << 32);
+    }
+    for (const Line &line : m_lines) {
+        hasher.add(static_cast<uint32_t>(line.health));
+    }
+    return hasher.h;
+}
+
+void GameSimulation::step(int n) {
+    for (int i = 0; i < n && m_result == MatchResult::Running; ++i) {
+        tickOnce();
+    }
+}
+
+void GameSimulation::tickOnce() {
+    TRACE_SCOPE(TracePhase::Tick);
+    m_tick++;
+
+    Scheduler::Event event;
+    while (m_schedule.popDue(m_tick, event)) {
+        TRACE_SCOPE(TracePhase::Spawn);
+        switch (event.type) {
+        case EVENT_COUNTDOWN_END:
+            // The first wave comes one second after the countdown
+            m_schedule.schedule(m_tick + TICKS_PER_SECOND, EVENT_WAVE);
+            break;
+        case EVENT_WAVE:
+            startWave();
+            break;
+        case EVENT_SPAWN_BEE:
+            spawnSingleBee();
+            break;
+        }
+    }
+
+    if (m_tick % TICKS_PER_BEE_UPDATE == 0) {
+        updateBees();
+    }
+}
+
+void GameSimulation::startWave() {
+    // One wave per second, one bee per tick after it starts. Every wave
+    // brings all of its bees; a wave of more than TICKS_PER_SECOND bees
+    // overlaps the next one.
+    m_currentWave++;
+    if (m_currentWave < m_totalWaves) {
+        m_schedule.schedule(m_tick + TICKS_PER_SECOND, EVENT_WAVE);
+    }
+    for (int i = 1; i <= m_params.beesPerWave; i++) {
+        m_schedule.schedule(m_tick + i, EVENT_SPAWN_BEE);
+    }
+}
+
+void GameSimulation::spawnSingleBee() {
+    int x = m_width + 100 + roll(0, 49);
+    int y = MARGIN + roll(0, m_height - BEE_SIZE - 1);
+    int health = roll(m_params.beeMinHealth, m_params.beeMaxHealth);
+    m_bees.push(x, y, health);
+}
+
+void GameSimulation::addBee(int x, int y, int health) {
+    m_bees.push(x, y, health);
+}
+
+PlaceResult GameSimulation::placeLine(SimPoint a, SimPoint b) {
+    if (m_result != MatchResult::Running ||
+        a.x < 0 || a.x >= cols() || a.y < 0 || a.y >= rows() ||
+        b.x < 0 || b.x >= cols() || b.y < 0 || b.y >= rows() ||
+        (a.x == b.x && a.y == b.y)) {
+        return PlaceResult::Invalid;
+    }
+
+    m_walls.openRuns(a.x, a.y, b.x, b.y, m_wallRuns);
+    if (m_wallRuns.empty()) {
+        return PlaceResult::AlreadyWalled;
+    }
+    unsigned long long requiredBlocks = 0;
+    for (const WallRun &run : m_wallRuns) {
+        requiredBlocks += m_blockCost[abs(run.bx - run.ax) * rows() + abs(run.by - run.ay)];
+    }
+    if (requiredBlocks > m_gameData.blocks) {
+        return PlaceResult::NotEnoughBlocks;
+    }
+
+    for (const WallRun &run : m_wallRuns) {
+        addLine(SimPoint{run.ax, run.ay}, SimPoint{run.bx, run.by});
+    }
+    m_gameData.blocks -= requiredBlocks;
+    return PlaceResult::Placed;
+}
+
+// A live line ending at at that runs on in the same straight line as a-b,
+// untouched so far (full health, no bee pinned on it), or -1
+int GameSimulation::extendableLine(SimPoint a, SimPoint b, SimPoint at) {
+    const SimPoint p = toPixel(at);
+    m_lineGrid.queryBox(p.x, p.y, p.x, p.y, m_candidates);
+    for (int l : m_candidates) {
+        const Line &line = m_lines[l];
+        const bool sharesEnd = (line.a.x == at.x && line.a.y == at.y) || (line.b.x == at.x && line.b.y == at.y);
+        const bool parallel = (line.b.x - line.a.x) * (b.y - a.y) == (line.b.y - line.a.y) * (b.x - a.x);
+        if (sharesEnd && parallel && line.health == m_params.lineHealth && m_contacts.beesOf(l).empty()) {
+            return l;
+        }
+    }
+    return -1;
+}
+
+void GameSimulation::setLineEnds(int line, SimPoint a, SimPoint b) {
+    const SimPoint p1 = toPixel(a);
+    const SimPoint p2 = toPixel(b);
+    const SimPoint old1 = toPixel(m_lines[line].a);
+    const SimPoint old2 = toPixel(m_lines[line].b);
+    m_lineGrid.removeSegment(line, old1.x, old1.y, old2.x, old2.y);
+    m_lines[line].a = a;
+    m_lines[line].b = b;
+    m_lineSegments.set(line, p1.x, p1.y, p2.x, p2.y);
+    m_lineGrid.insertSegment(line, p1.x, p1.y, p2.x, p2.y);
+}
+
+void GameSimulation::addLine(SimPoint a, SimPoint b) {
+    m_flow.addWall(a.x, a.y, b.x, b.y);
+    m_walls.add(a.x, a.y, b.x, b.y);
+
+    // A run that carries on an untouched line in a straight line makes that
+    // line longer instead of adding another, so a wall drawn piece by piece
+    // is still one line. Runs never overlap walled links, so the merged
+    // line covers exactly the links of its parts.
+    const int before = extendableLine(a, b, a);
+    const int after = extendableLine(a, b, b);
+    if (before >= 0 || after >= 0) {
+        SimPoint from = a;
+        SimPoint to = b;
+        if (before >= 0) {
+            const Line &line = m_lines[before];
+            from = line.a.x == a.x && line.a.y == a.y ? line.b : line.a;
+        }
+        if (after >= 0) {
+            const Line &line = m_lines[after];
+            to = line.a.x == b.x && line.a.y == b.y ? line.b : line.a;
+        }
+        int kept = before >= 0 ? before : after;
+        if (before >= 0 && after >= 0) {
+            // The run joins two lines: the older one takes over, so damage
+            // order stays the same, and the younger one goes (no bee is on it)
+            kept = m_lineSerial[before] < m_lineSerial[after] ? before : after;
+            const int dropped = kept == before ? after : before;
+            const SimPoint p1 = toPixel(m_lines[dropped].a);
+            const SimPoint p2 = toPixel(m_lines[dropped].b);
+            m_lineGrid.removeSegment(dropped, p1.x, p1.y, p2.x, p2.y);
+            m_lines[dropped].health = 0;
+            m_lineSlots.release(static_cast<uint32_t>(dropped));
+        }
+        setLineEnds(kept, from, to);
+        for (size_t i = 0; i < m_bees.size(); i++) {
+            if ((m_bees.flags[i] & BeeArray::STUNNED) && lineTouchesBee(kept, i)) {
+                m_contacts.add(m_bees.handle(i), kept);
+            }
+        }
+        return;
+    }
+
+    const Line newLine{a, b, m_params.lineHealth};
+    // Collision code works in arena pixels
+    const SimPoint p1 = toPixel(a);
+    const SimPoint p2 = toPixel(b);
+    // A destroyed line's slot is taken over before the arrays grow
+    const uint32_t slot = m_lineSlots.allocate();
+    const int index = static_cast<int>(slot);
+    if (slot == m_lines.size()) {
+        m_lines.push_back(newLine);
+        m_lineSerial.push_back(m_linesPlaced);
+        m_lineSegments.push(p1.x, p1.y, p2.x, p2.y);
+    } else {
+        m_lines[slot] = newLine;
+        m_lineSerial[slot] = m_linesPlaced;
+        m_lineSegments.set(slot, p1.x, p1.y, p2.x, p2.y);
+    }
+    m_linesPlaced++;
+    m_lineGrid.insertSegment(index, p1.x, p1.y, p2.x, p2.y);
+
+    // Bees already pinned may touch the new line too
+    for (size_t i = 0; i < m_bees.size(); i++) {
+        if ((m_bees.flags[i] & BeeArray::STUNNED) && lineTouchesBee(index, i)) {
+            m_contacts.add(m_bees.handle(i), index);
+        }
+    }
+}
+
+void GameSimulation::updateBees() {
+    if (m_tick < m_countdownEndTick || m_result != MatchResult::Running) {
+        return;
+    }
+
+    // Increment survival timer
+    m_survivalTimer++;
+
+    // Check win conditions
+    {
+        TRACE_SCOPE(TracePhase::WinCheck);
+        checkWinConditions();
+    }
+
+    if (m_result != MatchResult::Running) return;
+
+    // Check game over condition
+    if (m_gameData.current_hp <= 0) {
+        m_result = MatchResult::DogStung;
+        return;
+    }
+
+    // Health overflow check
+    const unsigned long long HEALTH_THRESHOLD = ULLONG_MAX * 3 / 4;
+    if (m_gameData.current_hp > HEALTH_THRESHOLD) {
+        m_result = MatchResult::InvalidHealth;
+        return;
+    }
+
+    // Update line health
+    {
+        TRACE_SCOPE(TracePhase::LineHealth);
+        updateLineHealth();
+    }
+
+    // The per-bee passes below interleave, so their time is summed per phase
+    TRACE_SPLITTER(split);
+    TRACE_ENTER(split, TracePhase::Movement);
+
+    m_bees.prevX = m_bees.x;
+    m_bees.prevY = m_bees.y;
+
+    BeeMoveParams move;
+    move.midX = m_width / 2;
+    move.spacing = m_spacing;
+
+    // Seekers with a line between them and the dog follow the flow field
+    // from their nearest lattice point; the rest head straight for the dog
+    m_targetX.resize(m_bees.size());
+    m_targetY.resize(m_bees.size());
+    for (size_t b = 0; b < m_bees.size(); b++) {
+        SimPoint target = m_dogPos;
+        if (m_bees.x[b] <= move.midX) {
+            const SimPoint at = nearestLattice(SimPoint{m_bees.x[b], m_bees.y[b]});
+            SimPoint next;
+            if (m_flow.waypoint(at.x, at.y, next.x, next.y)) {
+                target = toPixel(next);
+            }
+        }
+        m_targetX[b] = target.x;
+        m_targetY[b] = target.y;
+    }
+
+    // Move every free bee in one pass; stunned bees are left where they are
+    moveBees(m_bees.x.data(), m_bees.y.data(), m_targetX.data(), m_targetY.data(), m_bees.flags.data(),
+             m_bees.size(), move);
+
+    size_t i = 0;
+    while (i < m_bees.size()) {
+        TRACE_ENTER(split, TracePhase::Movement);
+        unsigned char &flags = m_bees.flags[i];
+        if (flags & BeeArray::STUNNED) {
+            if (++m_bees.stunnedTime[i] >= m_params.stunUpdates) {
+                m_bees.stunnedTime[i] = 0;
+                flags = BeeArray::MOVING;
+                m_contacts.removeBee(m_bees.handle(i));
+            }
+            i++;
+            continue;
+        }
+
+        if (!(flags & BeeArray::MOVING)) {
+            i++;
+            continue;
+        }
+
+        int &x = m_bees.x[i];
+        int &y = m_bees.y[i];
+
+        // Wall bouncing
+        if (x < 0) {
+            x = 0;
+            y += roll(-1, 1) * m_spacing;
+        }
+
+        if (y < 0) y = 0;
+        if (y > m_height - BEE_SIZE) y = m_height - BEE_SIZE;
+
+        // A step is wider than the lines, so stop at the first one in the way
+        TRACE_ENTER(split, TracePhase::LineCollision);
+        sweepBee(i, m_bees.prevX[i], m_bees.prevY[i]);
+
+        // Check dog collision
+        TRACE_ENTER(split, TracePhase::DogCollision);
+        if (boxesIntersect(m_dogPos, DOG_SIZE, SimPoint{x, y}, BEE_SIZE)) {
+            // hp is unsigned, so a sting takes at most what is left
+            const unsigned long long sting = static_cast<unsigned long long>(roll(m_params.dogMinDamage, m_params.dogMaxDamage));
+            m_gameData.current_hp -= std::min(sting, m_gameData.current_hp);
+            x += m_spacing * 5; // Bounce back
+            TRACE_ENTER(split, TracePhase::LineCollision);
+            sweepBee(i, x - m_spacing * 5, y);
+
+            if (m_gameData.current_hp <= 0) {
+                m_result = MatchResult::DogStung;
+                return;
+            }
+        }
+
+        // Check line collisions
+        TRACE_ENTER(split, TracePhase::LineCollision);
+        checkLineCollisions(i);
+
+        // Remove dead and off-screen bees, the last bee takes this slot
+        TRACE_ENTER(split, TracePhase::Culling);
+        if (m_bees.health[i] <= 0 || x < -100) {
+            removeBee(i);
+            continue;
+        }
+        i++;
+    }
+}
+
+void GameSimulation::checkWinConditions() {
+    // Survive long enough
+    if (m_survivalTimer >= m_params.survivalUpdates) {
+        playerWins(roll(m_params.minXp, m_params.maxXp));
+        return;
+    }
+
+    // All bees dead and all waves spawned
+    if (m_bees.empty() && m_currentWave >= m_totalWaves) {
+        playerWins(roll(m_params.minXp, m_params.maxXp));
+        return;
+    }
+}
+
+void GameSimulation::playerWins(int xpReward) {
+    m_result = MatchResult::Victory;
+    m_xpReward = xpReward;
+    m_gameData.auraxp += xpReward;
+    m_gameData.level++;
+}
+
+Box GameSimulation::beeBox(size_t beeIndex) const {
+    const float x = static_cast<float>(m_bees.x[beeIndex]);
+    const float y = static_cast<float>(m_bees.y[beeIndex]);
+    return Box{x, y, x + BEE_SIZE - 1, y + BEE_SIZE - 1};
+}
+
+bool GameSimulation::lineTouchesBee(int line, size_t beeIndex) const {
+    const SegmentArray &s = m_lineSegments;
+    return segmentTouchesBox(s.x1[line], s.y1[line], s.x2[line], s.y2[line], beeBox(beeIndex));
+}
+
+void GameSimulation::updateLineHealth() {
+    // Only lines with a bee pinned against them take damage, oldest first
+    m_scratch.assign(m_contacts.activeLines().begin(), m_contacts.activeLines().end());
+    std::sort(m_scratch.begin(), m_scratch.end(),
+              [this](int a, int b) { return m_lineSerial[a] < m_lineSerial[b]; });
+    for (int l : m_scratch) {
+        Line &line = m_lines[l];
+        // A line destroyed earlier in this pass may have freed every bee here
+        if (line.health <= 0 || m_contacts.beesOf(l).empty()) {
+            continue;
+        }
+        line.health -= roll(m_params.lineMinDamage, m_params.lineMaxDamage);
+        if (line.health <= 0) {
+            line.health = 0;
+            const SimPoint p1 = toPixel(line.a);
+            const SimPoint p2 = toPixel(line.b);
+            m_lineGrid.removeSegment(l, p1.x, p1.y, p2.x, p2.y);
+            m_flow.removeWall(line.a.x, line.a.y, line.b.x, line.b.y);
+            m_walls.remove(line.a.x, line.a.y, line.b.x, line.b.y);
+            freeBeesFromLine(l);
+            m_lineSlots.release(static_cast<uint32_t>(l));
+        }
+    }
+}
+
+void GameSimulation::freeBeesFromLine(int line) {
+    m_freedBees = m_contacts.beesOf(line);
+    for (Handle h : m_freedBees) {
+        const int b = m_bees.indexOf(h);
+        m_bees.flags[b] = BeeArray::MOVING;
+        m_bees.stunnedTime[b] = 0;
+        m_contacts.removeBee(h);
+    }
+}
+
+void GameSimulation::removeBee(size_t beeIndex) {
+    // The last bee moves into this index; its contacts go by its handle,
+    // which moves along
+    m_contacts.removeBee(m_bees.handle(beeIndex));
+    m_bees.remove(beeIndex);
+}
+
+void GameSimulation::sweepBee(size_t beeIndex, int fromX, int fromY) {
+    int &x = m_bees.x[beeIndex];
+    int &y = m_bees.y[beeIndex];
+    const int dx = x - fromX;
+    const int dy = y - fromY;
+    if (dx == 0 && dy == 0) {
+        return;
+    }
+
+    m_lineGrid.queryBox(std::min(fromX, x), std::min(fromY, y),
+                        std::max(fromX, x) + BEE_SIZE - 1, std::max(fromY, y) + BEE_SIZE - 1, m_candidates);
+    const float fx = static_cast<float>(fromX);
+    const float fy = static_cast<float>(fromY);
+    const Box from{fx, fy, fx + BEE_SIZE - 1, fy + BEE_SIZE - 1};
+    float first = 2;
+    int hit = -1;
+    for (int l : m_candidates) {
+        const SegmentArray &s = m_lineSegments;
+        // A line the bee starts on (it was just let go, or the line was put
+        // down on top of it) only counts if the bee still touches it where
+        // it ends up, which checkLineCollisions() sees to
+        float t;
+        if (m_lines[l].health > 0 &&
+            sweepBoxToSegment(s.x1[l], s.y1[l], s.x2[l], s.y2[l], from, static_cast<float>(dx), static_cast<float>(dy), t) &&
+            t > 0 && t < first) {
+            first = t;
+            hit = l;
+        }
+    }
+    if (hit < 0) {
+        return;
+    }
+    // Rounded on along the way, so the bee ends up touching the line. A
+    // graze too short to land on a whole pixel is flown through instead,
+    // or the bee would stop short of the line every update.
+    const float stepX = first * dx;
+    const float stepY = first * dy;
+    const int stopX = fromX + static_cast<int>(dx > 0 ? std::ceil(stepX) : std::floor(stepX));
+    const int stopY = fromY + static_cast<int>(dy > 0 ? std::ceil(stepY) : std::floor(stepY));
+    const float sx = static_cast<float>(stopX);
+    const float sy = static_cast<float>(stopY);
+    const SegmentArray &s = m_lineSegments;
+    if (segmentTouchesBox(s.x1[hit], s.y1[hit], s.x2[hit], s.y2[hit], Box{sx, sy, sx + BEE_SIZE - 1, sy + BEE_SIZE - 1})) {
+        x = stopX;
+        y = stopY;
+    }
+}
+
+void GameSimulation::checkLineCollisions(size_t beeIndex) {
+    const int x = m_bees.x[beeIndex];
+    const int y = m_bees.y[beeIndex];
+
+    m_lineGrid.queryBox(x, y, x + BEE_SIZE - 1, y + BEE_SIZE - 1, m_candidates);
+    // Pack the nearby live lines so they can be tested in one batch
+    m_packed.clear();
+    m_packedLines.clear();
+    for (int l : m_candidates) {
+        if (m_lines[l].health > 0) {
+            m_packed.push(m_lineSegments, l);
+            m_packedLines.push_back(l);
+        }
+    }
+    const Box box = beeBox(beeIndex);
+    const size_t count = m_packed.size();
+    size_t hit = firstSegmentTouchingBox(m_packed.x1.data(), m_packed.y1.data(), m_packed.x2.data(),
+                                         m_packed.y2.data(), count, box);
+    if (hit < count) {
+        m_bees.flags[beeIndex] = BeeArray::STUNNED | BeeArray::TOUCHING_LINE;
+
+        // The bee stays put while stunned, so its contacts are found once
+        while (hit < count) {
+            m_contacts.add(m_bees.handle(beeIndex), m_packedLines[hit]);
+            hit++;
+            hit += firstSegmentTouchingBox(m_packed.x1.data() + hit, m_packed.y1.data() + hit, m_packed.x2.data() + hit,
+                                           m_packed.y2.data() + hit, count - hit, box);
+        }
+
+        m_bees.health[beeIndex] -= roll(m_params.beeMinDamage, m_params.beeMaxDamage);
+        return;
+    }
+
+    m_bees.flags[beeIndex] &= ~BeeArray::TOUCHING_LINE;
+}
@@ -0,0 +1,206 @@
+#ifndef GAMESIMULATION_H
+#define GAMESIMULATION_H
+
+#include "defs.h"
+#include "rng.h"
+#include "beearray.h"
+#include "spatialgrid.h"
+#include "scheduler.h"
+#include "segmentbox.h"
+#include "slotallocator.h"
+#include "contactgraph.h"
+#include "flowfield.h"
+#include "wallmap.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Headless game engine. Everything in here is plain C++ so a match can be
+// played without a window, a display or wall-clock time.
+
+struct SimPoint {
+    int x;
+    int y;
+};
+
+// A wall between two lattice points; toPixel() gives its ends in the arena
+struct Line {
+    SimPoint a;
+    SimPoint b;
+    int health;
+};
+
+enum class MatchResult {
+    Running,
+    Victory,
+    DogStung,
+    InvalidHealth
+};
+
+enum class PlaceResult {
+    Placed,
+    NotEnoughBlocks,
+    AlreadyWalled,  // every part of the line is walled already
+    Invalid
+};
+
+// Balance knobs. Ranges are inclusive; times are in bee updates (one per
+// second of game time) unless noted.
+struct SimParams {
+    int gridCols = GRID_COLS;  // lattice points, clamped to the limits in defs.h
+    int gridRows = GRID_ROWS;
+    int countdownSeconds = 10;
+    int minWaves = 4;
+    int maxWaves = 5;
+    int beesPerWave = 5;
+    int beeMinHealth = 15;
+    int beeMaxHealth = 25;
+    int lineHealth = 20;
+    int lineMinDamage = 3;    // per update while a bee is pinned on the line
+    int lineMaxDamage = 7;
+    int beeMinDamage = 6;     // per update while a bee is pinned on a line
+    int beeMaxDamage = 16;
+    int dogMinDamage = 2;     // per sting
+    int dogMaxDamage = 3;
+    int stunUpdates = 60;
+    int survivalUpdates = 600;
+    int minXp = 30;
+    int maxXp = 400;
+
+    // Upper limits, far beyond anything playable, so that counts and tick
+    // arithmetic in the simulation stay small
+    static const int MAX_COUNTDOWN_SECONDS = 3600;
+    static const int MAX_WAVES = 1000;
+    static const int MAX_BEES_PER_WAVE = 1000;
+    static const int MAX_AMOUNT = 1000000;  // health, damage, updates, xp
+
+    // Nothing negative, no min above its max and nothing over the limits.
+    // Params from a file or the command line must pass this before a match
+    // is built from them.
+    bool valid() const;
+};
+
+class GameSimulation {
+public:
+    // One fixed step is 200 ms of game time, the old bee spawn cadence.
+    static const int TICKS_PER_SECOND = 5;
+    // Bees move once a second, on ticks that are a multiple of this
+    static const int TICKS_PER_BEE_UPDATE = TICKS_PER_SECOND;
+    static const int BEE_SIZE = 64;
+    static const int DOG_SIZE = 128;
+
+    // Every random draw comes from the simulation's own generator, so a
+    // seed fully determines the match given the same player input.
+    GameSimulation(datastorage &gameData, uint64_t seed, const SimParams &params = SimParams());
+
+    void reset();
+    // Starts over as a match with another seed, in the same arena
+    void reset(uint64_t seed);
+    void step(int n = 1);
+
+    // Endpoints are lattice coordinates, not pixels. Only the parts of the
+    // line that are not walled yet are placed (and paid for), each as a line
+    // of its own, so live lines never overlap. A part that carries on
+    // straight from an untouched line lengthens that line instead.
+    PlaceResult placeLine(SimPoint a, SimPoint b);
+
+    // Drops a bee straight into the arena, for tools and benchmarks.
+    void addBee(int x, int y, int health);
+
+    int cols() const { return m_params.gridCols; }
+    int rows() const { return m_params.gridRows; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int spacing() const { return m_spacing; }
+    long long tick() const { return m_tick; }
+    int countdownSeconds() const;
+    SimPoint dogPos() const { return m_dogPos; }
+    const BeeArray &bees() const { return m_bees; }
+    // Indexed by slot. A destroyed line keeps its slot, with health 0, until
+    // a newly placed line takes it over.
+    const std::vector<Line> &lines() const { return m_lines; }
+    // Lattice links covered by the live lines
+    const WallMap &walls() const { return m_walls; }
+    MatchResult result() const { return m_result; }
+    int xpReward() const { return m_xpReward; }
+    const datastorage &gameData() const { return m_gameData; }
+    const SimParams &params() const { return m_params; }
+    uint64_t seed() const { return m_seed; }
+
+    // Hash of everything that decides how the match goes on, for replays.
+    uint64_t stateHash() const;
+
+    // Which line holds a slot; changes when the line is destroyed, so a line
+    // that takes the slot over never looks like the one before it
+    Handle lineHandle(size_t index) const { return m_lineSlots.handle(static_cast<uint32_t>(index)); }
+
+    SimPoint toPixel(SimPoint gridPoint) const;
+    SimPoint toLattice(SimPoint pixel) const;
+
+private:
+    datastorage &m_gameData;
+    SimParams m_params;
+    uint64_t m_seed;
+    Rng m_rng;
+    int m_spacing;
+    int m_width;
+    int m_height;
+
+    // Countdown end, wave starts and bee spawns, fired at exact ticks
+    enum EventType {
+        EVENT_COUNTDOWN_END,
+        EVENT_WAVE,
+        EVENT_SPAWN_BEE
+    };
+
+    long long m_tick;
+    long long m_countdownEndTick;
+    Scheduler m_schedule;
+    int m_totalWaves;
+    int m_currentWave;
+    int m_survivalTimer;
+
+    SimPoint m_dogPos;
+    BeeArray m_bees;
+    std::vector<Line> m_lines;
+    SlotAllocator m_lineSlots;    // which m_lines slots are free
+    std::vector<unsigned> m_lineSerial;  // placement order of each slot's line
+    unsigned m_linesPlaced;
+    SegmentArray m_lineSegments;  // m_lines' endpoints as packed floats
+    SegmentArray m_packed;        // nearby live lines of one bee
+    SpatialGrid m_lineGrid;     // live lines, by the cells they cross
+    ContactGraph m_contacts;    // stunned bees and the lines they touch
+    FlowField m_flow;           // paths to the dog around the live lines
+    WallMap m_walls;            // lattice links under the live lines
+    std::vector<WallRun> m_wallRuns;
+    std::vector<uint16_t> m_blockCost;  // blocks for a line spanning (|dx|, |dy|), |dx|*rows + |dy|
+    std::vector<int> m_targetX;  // where each bee heads this update
+    std::vector<int> m_targetY;
+    std::vector<int> m_candidates;
+    std::vector<int> m_packedLines;   // line index of each m_packed entry
+    std::vector<int> m_scratch;
+    std::vector<Handle> m_freedBees;
+    MatchResult m_result;
+    int m_xpReward;
+
+    int roll(int lo, int hi);
+    void tickOnce();
+    void startWave();
+    void spawnSingleBee();
+    void addLine(SimPoint a, SimPoint b);
+    int extendableLine(SimPoint a, SimPoint b, SimPoint at);
+    void setLineEnds(int line, SimPoint a, SimPoint b);
+    void updateBees();
+    void updateLineHealth();
+    void sweepBee(size_t beeIndex, int fromX, int fromY);
+    void checkLineCollisions(size_t beeIndex);
+    SimPoint nearestLattice(SimPoint pixel) const;
+    Box beeBox(size_t beeIndex) const;
+    bool lineTouchesBee(int line, size_t beeIndex) const;
+    void freeBeesFromLine(int line);
+    void removeBee(size_t beeIndex);
+    void checkWinConditions();
+    void playerWins(int xpReward);
+};
+
+#endif // GAMESIMULATION_H
@@ -1,11 +1,15 @@
 #include "gridwidget.h"
+#include "trace.h"
 #include <QHBoxLayout>
 #include <QtMath>
 #include <QApplication>
+#include <QScreen>
 #include <QTimer>
-#include <chrono>
-#include <climits>
-#include <QMessageBox>
+
+namespace {
+const qreal ZOOM_STEP = 1.25;
+const int MAX_ZOOM_LEVEL = 6;   // about 4x
+}
 
 // Implement DraggableCounter methods
 void DraggableCounter::mousePressEvent(QMouseEvent *event) {
@@ -22,14 +26,23 @@ void DraggableCounter::mouseReleaseEvent(QMouseEvent *) {
 }
 
 // Implement GridWidget methods
-GridWidget::GridWidget(datastorage &gameData, QWidget *parent) 
-    : QWidget(parent), m_gameData(gameData), rng(std::random_device{}()) {
-    dogImage.load("doghead.png");
-    beeImage.load("bee.png");
+GridWidget::GridWidget(datastorage &gameData, uint64_t seed, const SimParams &params, QWidget *parent) 
+    : QWidget(parent), simThread(gameData, seed, params), matchOver(false), replaying(false), playbackSpeed(1),
+      zoomLevel(0), wheelZoom(0), panning(false), paintedTick(-1) {
+    simThread.refresh();
+    const SimSnapshot &state = simThread.state();
     
-    // Initialize game state
-    survivalTimer = 0;
-    gameActive = true;
+    // Open at 1:1, showing as much of the arena as the screen has room for
+    const QSize screen = QGuiApplication::primaryScreen()->availableGeometry().size();
+    resize(qMin(state.width, screen.width()), qMin(state.height, screen.height()));
+    setView(QPointF(0, 0), 0);
+    setWindowTitle("Save The Dogs");
+    // paintEvent covers every dirty pixel from the background cache
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setFocusPolicy(Qt::StrongFocus);
+    overlay.setFont(font());
+    counterShown = false;
+    lastCountdown = state.countdownSeconds;
     
     // Initialize countdown counter
     countdownCounter = new DraggableCounter(this);
@@ -37,14 +50,7 @@ GridWidget::GridWidget(datastorage &gameData, QWidget *parent)
     countdownCounter->setAlignment(Qt::AlignCenter);
     countdownCounter->move(width()/2 - 100, 10);
     countdownCounter->setFixedSize(300, 60);
-    countdownCounter->hide();
-    
-    initializeGameObjects();
-    
-    // Main game timer
-    QTimer *timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, &GridWidget::updateBees);
-    timer->start(1000);
+    countdownCounter->setText(QString("Countdown: %1 Seconds").arg(state.countdownSeconds));
     
     // Blocks/HP counter
     counter = new DraggableCounter(this);
@@ -53,400 +59,347 @@ GridWidget::GridWidget(datastorage &gameData, QWidget *parent)
     counter->move(width() - 150, 10);
     updateCounter();
     
-    // Calculate spacing and set window size
-    const int INITIAL_WINDOW_SIZE = 1600;
-    const float ASPECT_RATIO = 1.0f;
-    const int CELL_WIDTH = (INITIAL_WINDOW_SIZE - 2*MARGIN) / (GRID_COLS - 1);
-    const int CELL_HEIGHT = (INITIAL_WINDOW_SIZE*ASPECT_RATIO - 2*MARGIN) / (GRID_ROWS - 1);
-    SPACING = qMin(CELL_WIDTH, static_cast<int>(CELL_HEIGHT/ASPECT_RATIO));
-    setFixedSize(
-        MARGIN*2 + (GRID_COLS-1)*SPACING,
-        MARGIN*2 + (GRID_ROWS-1)*SPACING
-    );
-    setWindowTitle("Save The Dogs");
-    
-    // Start 10-second countdown
-    startCountdown();
+    // One timer per display frame; the simulation ticks on its own thread,
+    // started once the window is shown
+    frameTimer = new QTimer(this);
+    frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(frameTimer, &QTimer::timeout, this, &GridWidget::nextFrame);
 }
 
-void GridWidget::startCountdown() {
-    beeSpawnCountdown = 10;
-    totalBeesToSpawn = (rand() % 2) + 4; // 4-5 waves
-    currentSpawnWave = 0;
-    beesSpawnedThisWave = 0;
-    
-    countdownCounter->setText(QString("Countdown: %1 Seconds").arg(beeSpawnCountdown));
-    countdownCounter->show();
-    
-    QTimer *countdownTimer = new QTimer(this);
-    connect(countdownTimer, &QTimer::timeout, this, [this, countdownTimer]() {
-        beeSpawnCountdown--;
-        countdownCounter->setText(QString("Countdown: %1 Seconds").arg(beeSpawnCountdown));
-        
-        if (beeSpawnCountdown <= 0) {
-            countdownTimer->stop();
-            countdownTimer->deleteLater();
-            countdownCounter->hide();
-            startBeeWaves();
-        }
-    });
-    countdownTimer->start(1000);
+void GridWidget::playReplay(ReplayPlayer *player, double speed) {
+    replaying = true;
+    playbackSpeed = speed;
+    simThread.playReplay(player, speed);
+    setWindowTitle(QString("Save The Dogs - Replay %1").arg(static_cast<qulonglong>(simThread.seed())));
 }
 
-void GridWidget::startBeeWaves() {
-    QTimer *waveTimer = new QTimer(this);
-    connect(waveTimer, &QTimer::timeout, this, [this, waveTimer]() {
-        if (currentSpawnWave < totalBeesToSpawn) {
-            spawnBeeWave();
-            currentSpawnWave++;
-        } else {
-            waveTimer->stop();
-            waveTimer->deleteLater();
-        }
-    });
-    waveTimer->start(1000);
+void GridWidget::setSprites(const SpriteImages &images) {
+    for (int s = 0; s < SpriteCache::SpriteCount; s++) {
+        renderer.sprites().setSource(static_cast<SpriteCache::Sprite>(s), images.source[s], images.scaled[s], images.dpr);
+    }
+    update();
 }
 
-void GridWidget::spawnBeeWave() {
-    int beesThisWave = 5;
-    beesSpawnedThisWave = 0;
-    
-    QTimer *spawnTimer = new QTimer(this);
-    connect(spawnTimer, &QTimer::timeout, this, [this, spawnTimer, beesThisWave]() {
-        if (beesSpawnedThisWave < beesThisWave) {
-            spawnSingleBee();
-            beesSpawnedThisWave++;
-        } else {
-            spawnTimer->stop();
-            spawnTimer->deleteLater();
-        }
-    });
-    spawnTimer->start(200);
-}
+void GridWidget::newMatch(uint64_t seed) {
+    simThread.reset(seed);
+    simThread.refresh();
+    const SimSnapshot &state = simThread.state();
+    matchOver = false;
+    replaying = false;
+    playbackSpeed = 1;
+    setWindowTitle("Save The Dogs");
+    overlay.clear();
+    selectedPoints.clear();
+    panning = false;
+    unsetCursor();
 
-void GridWidget::spawnSingleBee() {
-    Bee bee;
-    bee.position = QPoint(width() + 100 + (rand() % 50), MARGIN + (rand() % (height() - 64)));
-    bee.direction = 0;
-    bee.moving = true;
-    bee.stunned = false;
-    bee.stunnedTime = 0;
-    bee.health = (rand() % 11) + 15; // 15-25 HP
-    bee.maxHealth = bee.health;
-    bee.touchingLine = false;
-    bees.push_back(bee);
+    // Nothing painted so far is worth keeping
+    paintedBeeRects.clear();
+    paintedTick = -1;
+    paintedLines.clear();
+    counterShown = false;
+    updateCounter();
+    lastCountdown = state.countdownSeconds;
+    countdownCounter->setText(QString("Countdown: %1 Seconds").arg(lastCountdown));
+    countdownCounter->show();
     update();
 }
 
+void GridWidget::showEvent(QShowEvent *e) {
+    QWidget::showEvent(e);
+    if (!frameTimer->isActive() && simThread.state().result == MatchResult::Running) {
+        simThread.start();
+        frameTimer->start(frameInterval());
+    }
+}
+
+void GridWidget::closeEvent(QCloseEvent *e) {
+    // The simulation writes to gameData, which the caller reads once we are gone
+    frameTimer->stop();
+    simThread.stop();
+    QWidget::closeEvent(e);
+}
+
 void GridWidget::updateCounter() {
+    const SimSnapshot &state = simThread.state();
+    if (counterShown && state.blocks == shownBlocks && state.hp == shownHp) {
+        return;
+    }
+    counterShown = true;
+    shownBlocks = state.blocks;
+    shownHp = state.hp;
     counter->setText(QString("Blocks Left: %1\nHP Left: %2")
-                      .arg(m_gameData.blocks)
-                      .arg(m_gameData.current_hp));
+                      .arg(state.blocks)
+                      .arg(state.hp));
     counter->adjustSize();
 }
 
-void GridWidget::initializeGameObjects() {
-    bees.clear();
-    drawnLines.clear();
-    selectedPoints.clear();
-    
-    // Random dog position
-    dogPos = QPoint(
-        MARGIN + (rand() % (width()/2 - 128)),
-        MARGIN + (rand() % (height() - 128))
-    );
+int GridWidget::frameInterval() const {
+    const qreal hz = screen() ? screen()->refreshRate() : 60;
+    return qMax(1, qRound(1000 / (hz > 0 ? hz : 60)));
 }
 
-void GridWidget::updateBees() {
-    if (beeSpawnCountdown > 0 || !gameActive) {
-        return;
+qreal GridWidget::beeBlend() const {
+    const SimSnapshot &state = simThread.state();
+    if (state.result != MatchResult::Running) {
+        return 1;
     }
-    
-    // Increment survival timer
-    survivalTimer++;
-    
-    // Check win conditions
-    checkWinConditions();
-    
-    if (!gameActive) return;
-    
-    // Check game over condition
-    if (m_gameData.current_hp <= 0) {
-        gameActive = false;
-        QMessageBox::information(this, "Game Over", "The dog has been stung too many times! Game Over!");
-        this->close();
-        return;
-    }
-    
-    // Health overflow check
-    const unsigned long long HEALTH_THRESHOLD = ULLONG_MAX * 3 / 4;
-    if (m_gameData.current_hp > HEALTH_THRESHOLD) {
-        gameActive = false;
-        QMessageBox::information(this, "Game Over", "Invalid health value detected! Game Over!");
-        this->close();
-        return;
+    // Ticks since the bees last moved, counting the part of a tick that
+    // has gone by in real time since the shown one was due
+    const double tickMs = 1000.0 / GameSimulation::TICKS_PER_SECOND / playbackSpeed;
+    const double sinceTickMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - state.tickTime).count();
+    const double since = state.tick % GameSimulation::TICKS_PER_BEE_UPDATE + qBound(0.0, sinceTickMs / tickMs, 1.0);
+    return qMin(1.0, since / GameSimulation::TICKS_PER_BEE_UPDATE);
+}
+
+void GridWidget::nextFrame() {
+    // Moving to another screen may change the refresh rate
+    const int interval = frameInterval();
+    if (frameTimer->interval() != interval) {
+        frameTimer->setInterval(interval);
     }
-    
-    // Update line health
-    updateLineHealth();
-    
-    for(size_t i = 0; i < bees.size(); i++) {
-        if (bees[i].stunned) {
-            bees[i].stunnedTime++;
-            if (bees[i].stunnedTime >= 60) {
-                bees[i].stunned = false;
-                bees[i].stunnedTime = 0;
-                bees[i].moving = true;
-                bees[i].touchingLine = false;
-            }
-            continue;
+
+    PlaceResult placed;
+    while (simThread.placeResult(placed)) {
+        if (placed == PlaceResult::NotEnoughBlocks) {
+            updateArena(GameRenderer::selectionRect(selectedPoints));
+            selectedPoints.clear();
+            overlay.post("You don't have enough blocks for that line.");
+        } else if (placed == PlaceResult::AlreadyWalled) {
+            updateArena(GameRenderer::selectionRect(selectedPoints));
+            selectedPoints.clear();
+            overlay.post("That line is already walled.");
         }
-        
-        if (!bees[i].moving) continue;
-        
-        // Move toward dog if past midline
-        if (bees[i].position.x() <= width() / 2) {
-            int dx = dogPos.x() - bees[i].position.x();
-            int dy = dogPos.y() - bees[i].position.y();
-            double distance = sqrt(dx*dx + dy*dy);
-            
-            if (distance > 0) {
-                bees[i].position.rx() += (dx / distance) * SPACING;
-                bees[i].position.ry() += (dy / distance) * SPACING;
-            }
+    }
+
+    // Never waits: either a newer state is ready or the last one is drawn again
+    if (simThread.refresh()) {
+        showState();
+    }
+    invalidateChanges();
+    if (simThread.state().result != MatchResult::Running) {
+        finishMatch();
+    }
+    const QRect overlayDirty = overlay.advance(size());
+    if (!overlayDirty.isEmpty()) {
+        update(overlayDirty);
+    }
+}
+
+void GridWidget::showState() {
+    const SimSnapshot &state = simThread.state();
+    if (state.countdownSeconds != lastCountdown) {
+        lastCountdown = state.countdownSeconds;
+        if (lastCountdown > 0) {
+            countdownCounter->setText(QString("Countdown: %1 Seconds").arg(lastCountdown));
         } else {
-            // Move left
-            bees[i].position.rx() -= SPACING * 2;
-        }
-        
-        // Wall bouncing
-        if (bees[i].position.x() < 0) {
-            bees[i].position.rx() = 0;
-            bees[i].position.ry() += (rand() % 3 - 1) * SPACING;
-        }
-        
-        if (bees[i].position.y() < 0) bees[i].position.ry() = 0;
-        if (bees[i].position.y() > height() - 64) bees[i].position.ry() = height() - 64;
-        
-        // Check dog collision
-        if (QRect(dogPos, QSize(128,128)).intersects(QRect(bees[i].position, QSize(64,64)))) {
-            m_gameData.current_hp -= (rand() % 2) + 2; // 2-3 damage
-            bees[i].position.rx() += SPACING * 5; // Bounce back
-            updateCounter();
-            
-            if (m_gameData.current_hp <= 0) {
-                gameActive = false;
-                QMessageBox::information(this, "Game Over", "The dog has been stung too many times! Game Over!");
-                this->close();
-                return;
-            }
-        }
-        
-        // Check line collisions
-        checkLineCollisions(i);
-        
-        // Remove dead bees
-        if (bees[i].health <= 0) {
-            bees.erase(bees.begin() + i);
-            i--;
-            continue;
-        }
-        
-        // Remove off-screen bees
-        if (bees[i].position.x() < -100) {
-            bees.erase(bees.begin() + i);
-            i--;
+            countdownCounter->hide();
         }
     }
-    update();
+    
+    updateCounter();
 }
 
-void GridWidget::checkWinConditions() {
-    // Survive for 10 seconds
-    if (survivalTimer >= 600) {
-        int xpReward = (rand() % 371) + 30; // 30-400 XP
-        playerWins(xpReward);
+void GridWidget::finishMatch() {
+    // The arena stays on screen under the result until the player is done
+    const SimSnapshot &state = simThread.state();
+    if (matchOver || state.result == MatchResult::Running) {
         return;
     }
-    
-    // All bees dead and all waves spawned
-    if (bees.empty() && currentSpawnWave >= totalBeesToSpawn) {
-        int xpReward = (rand() % 371) + 30; // 30-400 XP
-        playerWins(xpReward);
+    matchOver = true;
+    QString title;
+    QString text;
+    switch (state.result) {
+    case MatchResult::Victory:
+        title = "Victory!";
+        text = QString("You won! The dog is safe!\n\n"
+                       "You earned %1 Aura XP!\n\n"
+                       "You leveled up, you are now level %2!\n\n"
+                       "Total Aura XP: %3")
+                       .arg(state.xpReward)
+                       .arg(state.level)
+                       .arg(state.auraxp);
+        break;
+    case MatchResult::DogStung:
+        title = "Game Over";
+        text = "The dog has been stung too many times! Game Over!";
+        break;
+    case MatchResult::InvalidHealth:
+        title = "Game Over";
+        text = "Invalid health value detected! Game Over!";
+        break;
+    case MatchResult::Running:
         return;
     }
+    if (state.replayDivergedAt >= 0) {
+        text += QString("\n\nThis replay no longer matches the game, it went out of sync at tick %1.")
+                    .arg(state.replayDivergedAt);
+    }
+    overlay.setBanner(title, text + "\n\nClick or press any key to continue.");
 }
 
-void GridWidget::playerWins(int xpReward) {
-    gameActive = false;
-    m_gameData.auraxp += xpReward;
-    m_gameData.level++;
-    
-    QMessageBox::information(this, "Victory!", 
-        QString("You won! The dog is safe!\n\n"
-                "You earned %1 Aura XP!\n\n"
-                "You leveled up, you are now level %2!\n\n"
-                "Total Aura XP: %3")
-                .arg(xpReward)
-                .arg(m_gameData.level)
-                .arg(m_gameData.auraxp));
-    this->close();
-}
-
-void GridWidget::updateLineHealth() {
-    for (auto& line : drawnLines) {
-        if (line.health > 0) {
-            bool beeTouching = false;
-            for (const auto& bee : bees) {
-                if (bee.touchingLine) {
-                    QRect beeRect(bee.position.x(), bee.position.y(), 64, 64);
-                    QLineF topLine(beeRect.topLeft(), beeRect.topRight());
-                    QLineF bottomLine(beeRect.bottomLeft(), beeRect.bottomRight());
-                    QLineF leftLine(beeRect.topLeft(), beeRect.bottomLeft());
-                    QLineF rightLine(beeRect.topRight(), beeRect.bottomRight());
-                    
-                    QPointF intersectionPoint;
-                    if (line.line.intersects(topLine, &intersectionPoint) == QLineF::BoundedIntersection ||
-                        line.line.intersects(bottomLine, &intersectionPoint) == QLineF::BoundedIntersection ||
-                        line.line.intersects(leftLine, &intersectionPoint) == QLineF::BoundedIntersection ||
-                        line.line.intersects(rightLine, &intersectionPoint) == QLineF::BoundedIntersection) {
-                        beeTouching = true;
-                        break;
-                    }
-                }
+void GridWidget::invalidateChanges() {
+    // Bees: wherever one was painted last frame and wherever one is now.
+    // Between ticks the bees stay in the same slots with the same health,
+    // so only the ones that slid to another pixel need repainting.
+    const SimSnapshot &state = simThread.state();
+    const BeeArray &bees = state.bees;
+    const qreal blend = beeBlend();
+    if (state.tick == paintedTick && bees.size() == paintedBeeRects.size()) {
+        for (size_t i = 0; i < bees.size(); i++) {
+            const QPoint pos = GameRenderer::beePos(bees, i, blend);
+            const QRect r = GameRenderer::beeRect(pos.x(), pos.y());
+            if (r != paintedBeeRects[i]) {
+                updateArena(paintedBeeRects[i]);
+                updateArena(r);
+                paintedBeeRects[i] = r;
             }
-            
-            if (beeTouching) {
-                line.health -= (rand() % 5) + 3;
-                if (line.health <= 0) {
-                    line.health = 0;
-                    freeBeesFromLine(line);
-                }
+        }
+    } else {
+        for (const QRect &r : paintedBeeRects) {
+            updateArena(r);
+        }
+        paintedBeeRects.clear();
+        for (size_t i = 0; i < bees.size(); i++) {
+            const QPoint pos = GameRenderer::beePos(bees, i, blend);
+            QRect r = GameRenderer::beeRect(pos.x(), pos.y());
+            paintedBeeRects.push_back(r);
+            updateArena(r);
+        }
+        paintedTick = state.tick;
+    }
+    
+    // Lines: only the ones placed, damaged, lengthened or destroyed since
+    // the last frame. A slot can be freed and taken by a new line between
+    // two frames, so the handle tells a new line from the old one.
+    const std::vector<Line> &lines = state.lines;
+    paintedLines.resize(lines.size(), PaintedLine{Handle(), -1, QRect()});
+    for (size_t i = 0; i < lines.size(); i++) {
+        PaintedLine &painted = paintedLines[i];
+        const QRect r = GameRenderer::lineRect(state, lines[i]);
+        if (painted.handle != state.lineHandles[i] || painted.health != lines[i].health || painted.rect != r) {
+            if (!painted.rect.isNull() && painted.rect != r) {
+                updateArena(painted.rect);
             }
+            updateArena(r);
+            painted = PaintedLine{state.lineHandles[i], lines[i].health, r};
         }
     }
 }
 
-void GridWidget::freeBeesFromLine(const Line &destroyedLine) {
-    for (auto& bee : bees) {
-        if (bee.stunned) {
-            QRect beeRect(bee.position.x(), bee.position.y(), 64, 64);
-            QLineF topLine(beeRect.topLeft(), beeRect.topRight());
-            QLineF bottomLine(beeRect.bottomLeft(), beeRect.bottomRight());
-            QLineF leftLine(beeRect.topLeft(), beeRect.bottomLeft());
-            QLineF rightLine(beeRect.topRight(), beeRect.bottomRight());
-            
-            QPointF intersectionPoint;
-            if (destroyedLine.line.intersects(topLine, &intersectionPoint) == QLineF::BoundedIntersection ||
-                destroyedLine.line.intersects(bottomLine, &intersectionPoint) == QLineF::BoundedIntersection ||
-                destroyedLine.line.intersects(leftLine, &intersectionPoint) == QLineF::BoundedIntersection ||
-                destroyedLine.line.intersects(rightLine, &intersectionPoint) == QLineF::BoundedIntersection) {
-                
-                bee.stunned = false;
-                bee.moving = true;
-                bee.stunnedTime = 0;
-                bee.touchingLine = false;
-            }
-        }
+void GridWidget::updateArena(const QRect &arenaRect) {
+    // Changes off screen cost nothing
+    const QRect r = view.toScreen(arenaRect) & rect();
+    if (!r.isEmpty()) {
+        update(r);
     }
 }
 
-void GridWidget::checkLineCollisions(size_t beeIndex) {
-    bool isTouchingLine = false;
-    
-    for (auto& line : drawnLines) {
-        if (line.health > 0) {
-            QRect beeRect(bees[beeIndex].position.x(), bees[beeIndex].position.y(), 64, 64);
-            
-            QLineF topLine(beeRect.topLeft(), beeRect.topRight());
-            QLineF bottomLine(beeRect.bottomLeft(), beeRect.bottomRight());
-            QLineF leftLine(beeRect.topLeft(), beeRect.bottomLeft());
-            QLineF rightLine(beeRect.topRight(), beeRect.bottomRight());
-            
-            QPointF intersectionPoint;
-            if (line.line.intersects(topLine, &intersectionPoint) == QLineF::BoundedIntersection ||
-                line.line.intersects(bottomLine, &intersectionPoint) == QLineF::BoundedIntersection ||
-                line.line.intersects(leftLine, &intersectionPoint) == QLineF::BoundedIntersection ||
-                line.line.intersects(rightLine, &intersectionPoint) == QLineF::BoundedIntersection) {
-                
-                isTouchingLine = true;
-                bees[beeIndex].moving = false;
-                bees[beeIndex].stunned = true;
-                
-                // 6-16 damage per second
-                bees[beeIndex].health -= (rand() % 11) + 6;
-                
-                break;
-            }
-        }
+int GridWidget::clampZoomLevel(int level) const {
+    // Zoom out no further than the whole arena on screen, or 1:1 if it fits
+    const SimSnapshot &state = simThread.state();
+    const qreal fit = qMin(static_cast<qreal>(width()) / state.width, static_cast<qreal>(height()) / state.height);
+    const int minLevel = qMin(0, qFloor(qLn(fit) / qLn(ZOOM_STEP)));
+    return qBound(minLevel, level, MAX_ZOOM_LEVEL);
+}
+
+void GridWidget::setView(QPointF origin, int level) {
+    zoomLevel = clampZoomLevel(level);
+    const qreal zoom = qPow(ZOOM_STEP, zoomLevel);
+
+    // Scroll no further than the arena edges; an arena smaller than the
+    // view is centred. Whole screen pixels keep the sprites sharp.
+    auto clampAxis = [zoom](qreal o, int shown, int arena) {
+        const qreal span = shown / zoom;
+        o = span >= arena ? (arena - span) / 2 : qBound<qreal>(0, o, arena - span);
+        return qRound(o * zoom) / zoom;
+    };
+    const SimSnapshot &state = simThread.state();
+    ArenaView next;
+    next.origin = QPointF(clampAxis(origin.x(), width(), state.width), clampAxis(origin.y(), height(), state.height));
+    next.zoom = zoom;
+    next.size = size();
+    if (next != view) {
+        view = next;
+        update();
     }
-    
-    bees[beeIndex].touchingLine = isTouchingLine;
+}
+
+void GridWidget::resizeEvent(QResizeEvent *e) {
+    QWidget::resizeEvent(e);
+    setView(view.origin, zoomLevel);
 }
 
 void GridWidget::paintEvent(QPaintEvent *e) {
-    updateCounter();
-    Q_UNUSED(e);
+    TRACE_SCOPE(TracePhase::Paint);
+    // Qt clips the painter to the dirty region
     QPainter p(this);
-    p.setRenderHints(QPainter::Antialiasing);
-
-    // Background
-    p.fillRect(rect(), BG_COLOR);
-
-    // Grid points
-    p.setPen(GRID_COLOR);
-    p.setBrush(GRID_COLOR);
-    for (int y = 0; y < GRID_ROWS; ++y) {
-        for (int x = 0; x < GRID_COLS; ++x) {
-            int px = MARGIN + x * SPACING;
-            int py = MARGIN + y * SPACING;
-            p.drawEllipse(QPoint(px, py), POINT_RADIUS, POINT_RADIUS);
-        }
+    renderer.paint(p, e->rect(), devicePixelRatioF(), view, simThread.state(), beeBlend(), selectedPoints);
+    p.resetTransform();
+    overlay.paint(p, size());
+}
+
+void GridWidget::keyPressEvent(QKeyEvent *e) {
+    if (matchOver) {
+        close();
+        return;
     }
+    QWidget::keyPressEvent(e);
+}
 
-    // Lines with health bars
-    p.setPen(QPen(LINE_COLOR, LINE_WIDTH));
-    for (const Line &line : drawnLines) {
-        if (line.health > 0) {
-            p.drawLine(line.p1, line.p2);
-            
-            QPoint midPoint = (line.p1 + line.p2) / 2;
-            p.setPen(Qt::black);
-            p.drawRect(midPoint.x() - 10, midPoint.y() - 15, 20, 5);
-            p.fillRect(midPoint.x() - 10, midPoint.y() - 15, (line.health * 20) / 20, 5, Qt::green);
+void GridWidget::wheelEvent(QWheelEvent *e) {
+    if (e->modifiers() & Qt::ControlModifier) {
+        // Zoom around the cursor, one step per wheel notch
+        wheelZoom += e->angleDelta().y();
+        const int steps = wheelZoom / 120;
+        wheelZoom -= steps * 120;
+        const int level = clampZoomLevel(zoomLevel + steps);
+        if (level != zoomLevel) {
+            const QPointF cursor = e->position();
+            setView(view.toArena(cursor) - cursor / qPow(ZOOM_STEP, level), level);
+        }
+    } else {
+        // Scroll; shift turns a plain wheel sideways
+        QPointF delta = e->pixelDelta().isNull() ? QPointF(e->angleDelta()) : QPointF(e->pixelDelta());
+        if ((e->modifiers() & Qt::ShiftModifier) && delta.x() == 0) {
+            delta = QPointF(delta.y(), 0);
         }
+        setView(view.origin - delta / view.zoom, zoomLevel);
     }
+    e->accept();
+}
 
-    // Selected points and temporary lines
-    p.setPen(SELECT_COLOR);
-    p.setBrush(SELECT_COLOR);
-    if (!selectedPoints.empty()) {
-        p.drawEllipse(selectedPoints[0], POINT_RADIUS+1, POINT_RADIUS+1);
-        if (selectedPoints.size() == 2) {
-            p.drawEllipse(selectedPoints[1], POINT_RADIUS+1, POINT_RADIUS+1);
-            p.setPen(QPen(SELECT_COLOR, LINE_WIDTH));
-            p.drawLine(selectedPoints[0], selectedPoints[1]);
-        }
+void GridWidget::mouseMoveEvent(QMouseEvent *e) {
+    if (panning) {
+        setView(panOrigin - QPointF(e->pos() - panStart) / view.zoom, zoomLevel);
     }
+}
 
-    // Dog and bees
-    p.drawPixmap(dogPos.x(), dogPos.y(), 128, 128, dogImage);
-    
-    for(const auto& bee : bees) {
-        p.drawPixmap(bee.position.x(), bee.position.y(), 64, 64, beeImage);
-        
-        // Bee health bar
-        p.setPen(Qt::black);
-        p.drawRect(bee.position.x(), bee.position.y() - 10, 64, 5);
-        int healthWidth = (bee.health * 64) / bee.maxHealth;
-        p.fillRect(bee.position.x(), bee.position.y() - 10, healthWidth, 5, Qt::red);
+void GridWidget::mouseReleaseEvent(QMouseEvent *e) {
+    if (panning && (e->button() == Qt::RightButton || e->button() == Qt::MiddleButton)) {
+        panning = false;
+        unsetCursor();
     }
 }
 
 void GridWidget::mousePressEvent(QMouseEvent *e) {
-    if (e->button() == Qt::LeftButton) {
-        QPoint clickedP = getGridPoint(e->pos());
+    // Right or middle drag scrolls the arena
+    if (e->button() == Qt::RightButton || e->button() == Qt::MiddleButton) {
+        panning = true;
+        panStart = e->pos();
+        panOrigin = view.origin;
+        setCursor(Qt::ClosedHandCursor);
+        return;
+    }
+    if (matchOver) {
+        close();
+        return;
+    }
+    if (e->button() == Qt::LeftButton && !replaying) {
+        QPoint clickedP = getGridPoint(view.toArena(QPointF(e->pos())).toPoint());
         if (clickedP.x() != -1) {
+            updateArena(GameRenderer::selectionRect(selectedPoints));
             if (selectedPoints.size() < 2) {
                 selectedPoints.push_back(clickedP);
                 if (selectedPoints.size() == 2) {
@@ -454,52 +407,38 @@ void GridWidget::mousePressEvent(QMouseEvent *e) {
                     QPoint p2 = selectedPoints[1];
                     
                     // Calculate grid coordinates
-                    int gridX1 = (p1.x() - MARGIN) / SPACING;
-                    int gridY1 = (p1.y() - MARGIN) / SPACING;
-                    int gridX2 = (p2.x() - MARGIN) / SPACING;
-                    int gridY2 = (p2.y() - MARGIN) / SPACING;
+                    const SimSnapshot &state = simThread.state();
+                    SimPoint a = state.toLattice(SimPoint{p1.x(), p1.y()});
+                    SimPoint b = state.toLattice(SimPoint{p2.x(), p2.y()});
                     
-                    // Calculate differences in grid coordinates
-                    int xa = abs(gridX2 - gridX1);
-                    int ya = abs(gridY2 - gridY1);
-                    
-                    // Calculate Euclidean distance in grid units
-                    double distance = sqrt(xa * xa + ya * ya);
-                    int requiredBlocks = ceil(distance);
-                    
-                    if (requiredBlocks > m_gameData.blocks) {
-                        QMessageBox::warning(this, "Error", "Error: You don't have enough blocks.");
+                    // The simulation thread places it between ticks and
+                    // the line shows up with the next state; nextFrame
+                    // reports a refusal
+                    if (!simThread.placeLine(a, b)) {
                         selectedPoints.clear();
-                    } else {
-                        Line newLine;
-                        newLine.p1 = p1;
-                        newLine.p2 = p2;
-                        newLine.health = 20;
-                        newLine.line = QLineF(p1, p2);
-                        drawnLines.push_back(newLine);
-                        m_gameData.blocks -= requiredBlocks;
-                        updateCounter();
                     }
                 }
             } else {
                 selectedPoints.clear();
                 selectedPoints.push_back(clickedP);
             }
-            update();
+            updateArena(GameRenderer::selectionRect(selectedPoints));
         }
     }
 }
 
 QPoint GridWidget::getGridPoint(const QPoint &mouse) {
+    const SimSnapshot &state = simThread.state();
+    const int SPACING = state.spacing;
     int ox = mouse.x() - MARGIN;
     int oy = mouse.y() - MARGIN;
-    if (ox < 0 || oy < 0 || ox > (GRID_COLS-1)*SPACING || oy > (GRID_ROWS-1)*SPACING) {
+    if (ox < 0 || oy < 0 || ox > (state.cols-1)*SPACING || oy > (state.rows-1)*SPACING) {
         return QPoint(-1, -1);
     }
     int x = qRound(static_cast<double>(ox)/SPACING);
     int y = qRound(static_cast<double>(oy)/SPACING);
-    if (x >=0 && x < GRID_COLS && y >=0 && y < GRID_ROWS) {
+    if (x >=0 && x < state.cols && y >=0 && y < state.rows) {
         return QPoint(MARGIN + x*SPACING, MARGIN + y*SPACING);
     }
     return QPoint(-1, -1);
-}
\ No newline at end of file
+}
@@ -2,45 +2,24 @@
 #define GRIDWIDGET_H
 
 #include "defs.h"
+#include "gamerenderer.h"
+#include "replay.h"
+#include "simthread.h"
+#include "spriteloader.h"
+#include "toastoverlay.h"
 #include <QWidget>
 #include <QLabel>
 #include <QTimer>
 #include <QPainter>
 #include <QPixmap>
 #include <QMouseEvent>
-#include <QMessageBox>
+#include <QKeyEvent>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QShowEvent>
+#include <QCloseEvent>
+#include <QWheelEvent>
 #include <vector>
-#include <random>
-
-// Constants
-const int GRID_COLS = 48;
-const int GRID_ROWS = 24;
-const int POINT_RADIUS = 3;
-const int LINE_WIDTH = 2;
-const int MARGIN = 20;
-const QColor GRID_COLOR = Qt::blue;
-const QColor SELECT_COLOR = Qt::red;
-const QColor LINE_COLOR = Qt::darkGreen;
-const QColor BG_COLOR = Qt::white;
-
-// Line structure
-struct Line {
-    QPoint p1;
-    QPoint p2;
-    QLineF line;
-    int health;
-};
-
-struct Bee {
-    QPoint position;
-    int direction;
-    bool moving;
-    bool stunned;
-    int stunnedTime;
-    int health;
-    int maxHealth;
-    bool touchingLine;
-};
 
 class DraggableCounter : public QLabel {
 public:
@@ -56,50 +35,78 @@ private:
 class GridWidget : public QWidget {
     Q_OBJECT
 public:
-    explicit GridWidget(datastorage &gameData, QWidget *parent = nullptr);
+    GridWidget(datastorage &gameData, uint64_t seed, const SimParams &params = SimParams(),
+               QWidget *parent = nullptr);
+
+    // Plays a recording instead of taking mouse input. speed 1 is real time.
+    // Call before show().
+    void playReplay(ReplayPlayer *player, double speed);
+    void setSprites(const SpriteImages &images);
+    // Sets the window up for another match in the same arena, keeping the
+    // sprites and the view. Call while the window is closed, before show().
+    void newMatch(uint64_t seed);
+    // Complete once the window has been closed
+    const ReplayRecorder &recording() const { return simThread.recording(); }
     
 protected:
     void updateCounter();
-    void initializeGameObjects();
-    void updateBees();
+    void nextFrame();
+    void showState();
     void paintEvent(QPaintEvent *e) override;
+    void resizeEvent(QResizeEvent *e) override;
+    void showEvent(QShowEvent *e) override;
+    void closeEvent(QCloseEvent *e) override;
     void mousePressEvent(QMouseEvent *e) override;
+    void keyPressEvent(QKeyEvent *e) override;
+    void mouseMoveEvent(QMouseEvent *e) override;
+    void mouseReleaseEvent(QMouseEvent *e) override;
+    void wheelEvent(QWheelEvent *e) override;
     
 private:
-    QPixmap dogImage;
-    QPixmap beeImage;
-    QPoint dogPos;
-    std::vector<QPoint> beePositions;
-    std::vector<int> beeDirections;
-    std::mt19937 rng;
-    datastorage &m_gameData;
+    // The window only ever sees the snapshots the simulation thread hands
+    // over; frames follow the display, ticks follow the simulation's clock
+    SimThread simThread;
+    GameRenderer renderer;
+    ToastOverlay overlay;
+    bool matchOver;       // the result banner is up, any click or key closes
+    bool replaying;
+    double playbackSpeed;
+    QTimer *frameTimer;
     DraggableCounter *counter;
     DraggableCounter *countdownCounter;
-    std::vector<QPoint> selectedPoints;
-    std::vector<Line> drawnLines;
-    int SPACING;
-    int beeSpawnCountdown;
+    std::vector<QPoint> selectedPoints;  // arena pixels
 
-    QPoint getGridPoint(const QPoint &mouse);
-    void startCountdown();
-    void spawnBees();
-    std::vector<Bee> bees;
-    int totalBeesToSpawn;
-    int currentSpawnWave;
-    int beesSpawnedThisWave;
-    
-    void startBeeWaves();
-    void spawnBeeWave();
-    void spawnSingleBee();
-    void updateLineHealth();
-    void checkLineCollisions(size_t beeIndex);
-    void freeBeesFromLine(const Line &destroyedLine);
+    // Scrolled and zoomed view of the arena. Zoom comes in steps of
+    // ZOOM_STEP so the sprite cache sees a handful of scales.
+    ArenaView view;
+    int zoomLevel;
+    int wheelZoom;        // wheel angle not yet turned into a zoom step
+    bool panning;
+    QPoint panStart;
+    QPointF panOrigin;
     
-    // Win condition variables
-    int survivalTimer;
-    bool gameActive;
-    void checkWinConditions();
-    void playerWins(int xpReward);
+    // What the last frame showed, so only changes get repainted
+    std::vector<QRect> paintedBeeRects;
+    long long paintedTick;
+    struct PaintedLine {
+        Handle handle;
+        int health;
+        QRect rect;
+    };
+    std::vector<PaintedLine> paintedLines;
+    bool counterShown;
+    unsigned long long shownBlocks;
+    unsigned long long shownHp;
+    int lastCountdown;
+
+    QPoint getGridPoint(const QPoint &mouse);
+    int frameInterval() const;
+    qreal beeBlend() const;
+    void updateArena(const QRect &arenaRect);
+    int clampZoomLevel(int level) const;
+    void setView(QPointF origin, int level);
+    void invalidateChanges();
+    void finishMatch();
 };
 
-#endif // GRIDWIDGET_H
\ No newline at end of file
+#endif // GRIDWIDGET_H
@@ -0,0 +1,153 @@
+#include "movebees.h"
+#include "beearray.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MOVEBEES_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MOVEBEES_SSE2
+#endif
+
+namespace {
+
+const unsigned char ACTIVE_MASK = BeeArray::MOVING | BeeArray::STUNNED;
+
+inline void moveOne(int &x, int &y, int targetX, int targetY, const BeeMoveParams &params) {
+    if (x <= params.midX) {
+        const int dx = targetX - x;
+        const int dy = targetY - y;
+        const float fdx = static_cast<float>(dx);
+        const float fdy = static_cast<float>(dy);
+        const float d2 = fdx * fdx + fdy * fdy;
+        if (d2 > 0) {
+            const float scale = static_cast<float>(params.spacing) / std::sqrt(d2);
+            x = static_cast<int>(static_cast<float>(x) + fdx * scale);
+            y = static_cast<int>(static_cast<float>(y) + fdy * scale);
+        }
+    } else {
+        x -= params.spacing * 2;
+    }
+}
+
+} // namespace
+
+void moveBeesScalar(int *x, int *y, const int *targetX, const int *targetY, const unsigned char *flags,
+                    size_t count, const BeeMoveParams &params) {
+    for (size_t i = 0; i < count; ++i) {
+        if ((flags[i] & ACTIVE_MASK) == BeeArray::MOVING) {
+            moveOne(x[i], y[i], targetX[i], targetY[i], params);
+        }
+    }
+}
+
+#if defined(MOVEBEES_AVX2)
+
+void moveBees(int *x, int *y, const int *targetX, const int *targetY, const unsigned char *flags,
+              size_t count, const BeeMoveParams &params) {
+    const __m256i midX = _mm256_set1_epi32(params.midX);
+    const __m256i leftStep = _mm256_set1_epi32(params.spacing * 2);
+    const __m256i activeMask = _mm256_set1_epi32(ACTIVE_MASK);
+    const __m256i moving = _mm256_set1_epi32(BeeArray::MOVING);
+    const __m256 spacing = _mm256_set1_ps(static_cast<float>(params.spacing));
+    const __m256 zero = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i));
+        __m256i vy = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i));
+        __m256i tx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(targetX + i));
+        __m256i ty = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(targetY + i));
+        __m256i vf = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(flags + i)));
+
+        __m256i active = _mm256_cmpeq_epi32(_mm256_and_si256(vf, activeMask), moving);
+        __m256i flyLeft = _mm256_cmpgt_epi32(vx, midX);
+
+        __m256 fx = _mm256_cvtepi32_ps(vx);
+        __m256 fy = _mm256_cvtepi32_ps(vy);
+        __m256 fdx = _mm256_cvtepi32_ps(_mm256_sub_epi32(tx, vx));
+        __m256 fdy = _mm256_cvtepi32_ps(_mm256_sub_epi32(ty, vy));
+        __m256 d2 = _mm256_add_ps(_mm256_mul_ps(fdx, fdx), _mm256_mul_ps(fdy, fdy));
+        __m256 scale = _mm256_div_ps(spacing, _mm256_sqrt_ps(d2));
+        __m256i seekX = _mm256_cvttps_epi32(_mm256_add_ps(fx, _mm256_mul_ps(fdx, scale)));
+        __m256i seekY = _mm256_cvttps_epi32(_mm256_add_ps(fy, _mm256_mul_ps(fdy, scale)));
+        __m256i hasDistance = _mm256_castps_si256(_mm256_cmp_ps(d2, zero, _CMP_GT_OQ));
+        seekX = _mm256_blendv_epi8(vx, seekX, hasDistance);
+        seekY = _mm256_blendv_epi8(vy, seekY, hasDistance);
+
+        __m256i nx = _mm256_blendv_epi8(seekX, _mm256_sub_epi32(vx, leftStep), flyLeft);
+        __m256i ny = _mm256_blendv_epi8(seekY, vy, flyLeft);
+        nx = _mm256_blendv_epi8(vx, nx, active);
+        ny = _mm256_blendv_epi8(vy, ny, active);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(x + i), nx);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(y + i), ny);
+    }
+    moveBeesScalar(x + i, y + i, targetX + i, targetY + i, flags + i, count - i, params);
+}
+
+#elif defined(MOVEBEES_SSE2)
+
+namespace {
+// SSE2 has no blendv, pick b where mask is set
+inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a));
+}
+}
+
+void moveBees(int *x, int *y, const int *targetX, const int *targetY, const unsigned char *flags,
+              size_t count, const BeeMoveParams &params) {
+    const __m128i midX = _mm_set1_epi32(params.midX);
+    const __m128i leftStep = _mm_set1_epi32(params.spacing * 2);
+    const __m128i activeMask = _mm_set1_epi32(ACTIVE_MASK);
+    const __m128i moving = _mm_set1_epi32(BeeArray::MOVING);
+    const __m128i zeroi = _mm_setzero_si128();
+    const __m128 spacing = _mm_set1_ps(static_cast<float>(params.spacing));
+    const __m128 zero = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i vx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i));
+        __m128i vy = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+        __m128i tx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(targetX + i));
+        __m128i ty = _mm_loadu_si128(reinterpret_cast<const __m128i *>(targetY + i));
+        int packedFlags;
+        std::memcpy(&packedFlags, flags + i, sizeof(packedFlags));
+        __m128i vf = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packedFlags), zeroi), zeroi);
+
+        __m128i active = _mm_cmpeq_epi32(_mm_and_si128(vf, activeMask), moving);
+        __m128i flyLeft = _mm_cmpgt_epi32(vx, midX);
+
+        __m128 fx = _mm_cvtepi32_ps(vx);
+        __m128 fy = _mm_cvtepi32_ps(vy);
+        __m128 fdx = _mm_cvtepi32_ps(_mm_sub_epi32(tx, vx));
+        __m128 fdy = _mm_cvtepi32_ps(_mm_sub_epi32(ty, vy));
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(fdx, fdx), _mm_mul_ps(fdy, fdy));
+        __m128 scale = _mm_div_ps(spacing, _mm_sqrt_ps(d2));
+        __m128i seekX = _mm_cvttps_epi32(_mm_add_ps(fx, _mm_mul_ps(fdx, scale)));
+        __m128i seekY = _mm_cvttps_epi32(_mm_add_ps(fy, _mm_mul_ps(fdy, scale)));
+        __m128i hasDistance = _mm_castps_si128(_mm_cmpgt_ps(d2, zero));
+        seekX = select(hasDistance, vx, seekX);
+        seekY = select(hasDistance, vy, seekY);
+
+        __m128i nx = select(flyLeft, seekX, _mm_sub_epi32(vx, leftStep));
+        __m128i ny = select(flyLeft, seekY, vy);
+        nx = select(active, vx, nx);
+        ny = select(active, vy, ny);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(x + i), nx);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(y + i), ny);
+    }
+    moveBeesScalar(x + i, y + i, targetX + i, targetY + i, flags + i, count - i, params);
+}
+
+#else
+
+void moveBees(int *x, int *y, const int *targetX, const int *targetY, const unsigned char *flags,
+              size_t count, const BeeMoveParams &params) {
+    moveBeesScalar(x, y, targetX, targetY, flags, count, params);
+}
+
+#endif
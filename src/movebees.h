@@ -0,0 +1,22 @@
+#ifndef MOVEBEES_H
+#define MOVEBEES_H
+
+#include <cstddef>
+
+// Parameters of one movement step, shared by every bee.
+struct BeeMoveParams {
+    int midX;      // bees at or left of this seek their target
+    int spacing;
+};
+
+// Moves every bee whose flags are exactly MOVING and not STUNNED: bees past
+// the midline take one SPACING step toward their own target, the rest fly
+// left by two. Uses AVX2 or SSE2 when the compiler targets them;
+// moveBeesScalar() gives bit-identical results (game.pri turns off FMA
+// contraction, which would break that) and handles the tail.
+void moveBees(int *x, int *y, const int *targetX, const int *targetY, const unsigned char *flags,
+              size_t count, const BeeMoveParams &params);
+void moveBeesScalar(int *x, int *y, const int *targetX, const int *targetY, const unsigned char *flags,
+                    size_t count, const BeeMoveParams &params);
+
+#endif // MOVEBEES_H
@@ -0,0 +1,3 @@
+# Qt painting of the game state, shared by the game and the benchmark targets
+HEADERS += $$PWD/gamerenderer.h $$PWD/spritecache.h
+SOURCES += $$PWD/gamerenderer.cpp $$PWD/spritecache.cpp
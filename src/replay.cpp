@@ -0,0 +1,273 @@
+#include "replay.h"
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const char MAGIC[4] = {'S', 'D', 'R', 'P'};
+const uint32_t VERSION = 8;
+
+enum : unsigned char {
+    EVENT_PLACE = 1,
+    EVENT_CHECKSUM = 2,
+    EVENT_END = 3
+};
+
+// Serialised in this order; a replay with a different count is rejected
+int SimParams::*const PARAM_FIELDS[] = {
+    &SimParams::countdownSeconds, &SimParams::minWaves, &SimParams::maxWaves,
+    &SimParams::beesPerWave, &SimParams::beeMinHealth, &SimParams::beeMaxHealth,
+    &SimParams::lineHealth, &SimParams::lineMinDamage, &SimParams::lineMaxDamage,
+    &SimParams::beeMinDamage, &SimParams::beeMaxDamage, &SimParams::dogMinDamage,
+    &SimParams::dogMaxDamage, &SimParams::stunUpdates, &SimParams::survivalUpdates,
+    &SimParams::minXp, &SimParams::maxXp, &SimParams::gridCols, &SimParams::gridRows
+};
+const uint32_t PARAM_COUNT = sizeof(PARAM_FIELDS) / sizeof(PARAM_FIELDS[0]);
+
+void putU32(std::vector<unsigned char> &out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<unsigned char>(v >> (8 * i)));
+}
+
+void putU16(std::vector<unsigned char> &out, uint16_t v) {
+    out.push_back(static_cast<unsigned char>(v));
+    out.push_back(static_cast<unsigned char>(v >> 8));
+}
+
+void putU64(std::vector<unsigned char> &out, uint64_t v) {
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<unsigned char>(v >> (8 * i)));
+}
+
+void putVarint(std::vector<unsigned char> &out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<unsigned char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(v));
+}
+
+uint16_t getU16(const unsigned char *p) {
+    return static_cast<uint16_t>(p[0] | p[1] << 8);
+}
+
+uint32_t getU32(const unsigned char *p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+uint64_t getU64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+size_t payloadSize(unsigned char type) {
+    switch (type) {
+    case EVENT_PLACE: return 8;
+    case EVENT_CHECKSUM: return 8;
+    case EVENT_END: return 9;
+    default: return 0;
+    }
+}
+
+} // namespace
+
+void ReplayRecorder::begin(const GameSimulation &sim) {
+    const datastorage &data = sim.gameData();
+    m_bytes.clear();
+    for (char c : MAGIC) {
+        m_bytes.push_back(static_cast<unsigned char>(c));
+    }
+    putU32(m_bytes, VERSION);
+    putU64(m_bytes, sim.seed());
+    putU64(m_bytes, data.auraxp);
+    putU64(m_bytes, data.boughtblocks);
+    putU64(m_bytes, data.boughthp);
+    putU64(m_bytes, data.level);
+    putU64(m_bytes, data.blocks);
+    putU64(m_bytes, data.current_hp);
+    putU32(m_bytes, PARAM_COUNT);
+    for (int SimParams::*field : PARAM_FIELDS) {
+        putU32(m_bytes, static_cast<uint32_t>(sim.params().*field));
+    }
+    m_lastTick = sim.tick();
+    m_ended = false;
+}
+
+void ReplayRecorder::putEvent(unsigned char type, long long tick) {
+    m_bytes.push_back(type);
+    putVarint(m_bytes, static_cast<uint64_t>(tick - m_lastTick));
+    m_lastTick = tick;
+}
+
+void ReplayRecorder::placed(const GameSimulation &sim, SimPoint a, SimPoint b) {
+    putEvent(EVENT_PLACE, sim.tick());
+    // Lattice coordinates go up to MAX_GRID_POINTS, two bytes each
+    putU16(m_bytes, static_cast<uint16_t>(a.x));
+    putU16(m_bytes, static_cast<uint16_t>(a.y));
+    putU16(m_bytes, static_cast<uint16_t>(b.x));
+    putU16(m_bytes, static_cast<uint16_t>(b.y));
+}
+
+void ReplayRecorder::ticked(const GameSimulation &sim) {
+    if (m_ended) {
+        return;
+    }
+    if (sim.result() != MatchResult::Running) {
+        putEvent(EVENT_END, sim.tick());
+        m_bytes.push_back(static_cast<unsigned char>(sim.result()));
+        putU64(m_bytes, sim.stateHash());
+        m_ended = true;
+    } else if (sim.tick() % CHECKSUM_INTERVAL == 0) {
+        putEvent(EVENT_CHECKSUM, sim.tick());
+        putU64(m_bytes, sim.stateHash());
+    }
+}
+
+bool ReplayRecorder::save(const std::string &path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(m_bytes.data()), static_cast<std::streamsize>(m_bytes.size()));
+    return out.good();
+}
+
+bool ReplayPlayer::load(const unsigned char *data, size_t size, std::string &error) {
+    const size_t fixedSize = 4 + 4 + 8 + 6 * 8 + 4;
+    if (size < fixedSize || memcmp(data, MAGIC, 4) != 0) {
+        error = "not a replay file";
+        return false;
+    }
+    if (getU32(data + 4) != VERSION || getU32(data + fixedSize - 4) != PARAM_COUNT) {
+        error = "replay was recorded by a different version of the game";
+        return false;
+    }
+    if (size < fixedSize + PARAM_COUNT * 4) {
+        error = "replay is truncated";
+        return false;
+    }
+
+    const unsigned char *p = data + 8;
+    m_header.seed = getU64(p);
+    m_header.start.auraxp = getU64(p + 8);
+    m_header.start.boughtblocks = getU64(p + 16);
+    m_header.start.boughthp = getU64(p + 24);
+    m_header.start.level = getU64(p + 32);
+    m_header.start.blocks = getU64(p + 40);
+    m_header.start.current_hp = getU64(p + 48);
+    p = data + fixedSize;
+    for (int SimParams::*field : PARAM_FIELDS) {
+        m_header.params.*field = static_cast<int>(getU32(p));
+        p += 4;
+    }
+    // A damaged or hand-edited header must not reach the simulation
+    if (!m_header.params.valid()) {
+        error = "replay has invalid match parameters";
+        return false;
+    }
+
+    m_pos = p;
+    m_end = data + size;
+    m_nextTick = 0;
+    m_reachedEnd = false;
+    m_divergedAt = -1;
+    m_recordedResult = MatchResult::Running;
+    advance();
+    return true;
+}
+
+void ReplayPlayer::advance() {
+    m_nextType = 0;
+    if (m_reachedEnd || m_pos >= m_end) {
+        return;
+    }
+    const unsigned char type = *m_pos++;
+    uint64_t delta = 0;
+    for (int shift = 0; ; shift += 7) {
+        if (m_pos >= m_end || shift > 63) {
+            return;
+        }
+        const unsigned char byte = *m_pos++;
+        delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    const size_t payload = payloadSize(type);
+    // A torn or unknown event ends the recording
+    if (payload == 0 || static_cast<size_t>(m_end - m_pos) < payload) {
+        return;
+    }
+    m_nextType = type;
+    m_nextTick += static_cast<long long>(delta);
+    m_payload = m_pos;
+    m_pos += payload;
+}
+
+void ReplayPlayer::diverge(long long tick) {
+    if (m_divergedAt < 0) {
+        m_divergedAt = tick;
+    }
+}
+
+void ReplayPlayer::applyInput(GameSimulation &sim) {
+    while (m_nextType == EVENT_PLACE && m_nextTick <= sim.tick()) {
+        SimPoint a{getU16(m_payload), getU16(m_payload + 2)};
+        SimPoint b{getU16(m_payload + 4), getU16(m_payload + 6)};
+        if (m_nextTick < sim.tick() || sim.placeLine(a, b) != PlaceResult::Placed) {
+            diverge(sim.tick());
+        }
+        advance();
+    }
+}
+
+void ReplayPlayer::check(const GameSimulation &sim) {
+    while (m_nextType != 0 && m_nextType != EVENT_PLACE && m_nextTick <= sim.tick()) {
+        if (m_nextTick < sim.tick()) {
+            diverge(sim.tick());
+        } else if (m_nextType == EVENT_CHECKSUM) {
+            if (getU64(m_payload) != sim.stateHash()) {
+                diverge(sim.tick());
+            }
+        } else {
+            m_recordedResult = static_cast<MatchResult>(m_payload[0]);
+            m_reachedEnd = true;
+            if (m_recordedResult != sim.result() || getU64(m_payload + 1) != sim.stateHash()) {
+                diverge(sim.tick());
+            }
+        }
+        advance();
+    }
+    // The match is over but the recording goes on
+    if (sim.result() != MatchResult::Running && !m_reachedEnd) {
+        diverge(sim.tick());
+    }
+}
+
+ReplayVerdict verifyReplay(const unsigned char *data, size_t size) {
+    ReplayVerdict verdict;
+    verdict.ticks = 0;
+    verdict.divergedAt = -1;
+    verdict.complete = false;
+    verdict.recorded = MatchResult::Running;
+    verdict.replayed = MatchResult::Running;
+
+    ReplayPlayer player;
+    verdict.loaded = player.load(data, size, verdict.error);
+    if (!verdict.loaded) {
+        return verdict;
+    }
+
+    datastorage gameData = player.header().start;
+    GameSimulation sim(gameData, player.header().seed, player.header().params);
+    while (!player.atEnd() && player.divergedAt() < 0) {
+        player.applyInput(sim);
+        sim.step();
+        player.check(sim);
+    }
+
+    verdict.ticks = sim.tick();
+    verdict.divergedAt = player.divergedAt();
+    verdict.complete = player.reachedEnd();
+    verdict.recorded = player.recordedResult();
+    verdict.replayed = sim.result();
+    return verdict;
+}
@@ -0,0 +1,96 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "gamesimulation.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Match replays. The simulation is deterministic, so a replay only stores
+// what went into it: the seed, the starting datastorage, the balance params
+// and every placed line with the tick it was placed before. State checksums
+// every few seconds let playback report the first tick where a changed
+// simulation no longer matches the recording.
+//
+// Layout (little endian): "SDRP", u32 version (8), u64 seed, 6 x u64
+// datastorage, u32 param count, that many i32 params, then events. Each
+// event is a u8 type, the tick delta to the previous event as a varint and
+// a payload: 4 x u16 lattice coords (ax, ay, bx, by) for Place, a u64
+// checksum for Checksum, u8 result + u64 checksum for End. Any change to
+// the layout or to how a match plays out bumps the version.
+
+struct ReplayHeader {
+    uint64_t seed;
+    datastorage start;
+    SimParams params;
+};
+
+class ReplayRecorder {
+public:
+    static const int CHECKSUM_INTERVAL = 5 * GameSimulation::TICKS_PER_SECOND;
+
+    // Call before the first step, while sim.gameData() is still the start.
+    void begin(const GameSimulation &sim);
+    // Call for every line that placeLine() accepted.
+    void placed(const GameSimulation &sim, SimPoint a, SimPoint b);
+    // Call after every step. Writes the End event once the match is over.
+    void ticked(const GameSimulation &sim);
+
+    const std::vector<unsigned char> &bytes() const { return m_bytes; }
+    bool save(const std::string &path) const;
+
+private:
+    std::vector<unsigned char> m_bytes;
+    long long m_lastTick = 0;
+    bool m_ended = false;
+
+    void putEvent(unsigned char type, long long tick);
+};
+
+// Walks a recording and feeds it to a simulation built from its header.
+// The bytes are not copied, they must stay valid (e.g. a MappedFile).
+class ReplayPlayer {
+public:
+    bool load(const unsigned char *data, size_t size, std::string &error);
+    const ReplayHeader &header() const { return m_header; }
+
+    // Places the lines recorded for the coming tick; call before sim.step().
+    void applyInput(GameSimulation &sim);
+    // Compares sim with the recording; call after sim.step().
+    void check(const GameSimulation &sim);
+
+    // No events left. Recordings of abandoned matches stop without an End.
+    bool atEnd() const { return m_nextType == 0; }
+    bool reachedEnd() const { return m_reachedEnd; }
+    long long divergedAt() const { return m_divergedAt; }
+    MatchResult recordedResult() const { return m_recordedResult; }
+
+private:
+    ReplayHeader m_header;
+    const unsigned char *m_pos = nullptr;
+    const unsigned char *m_end = nullptr;
+    // The next event, decoded ahead
+    unsigned char m_nextType = 0;
+    long long m_nextTick = 0;
+    const unsigned char *m_payload = nullptr;
+    bool m_reachedEnd = false;
+    long long m_divergedAt = -1;
+    MatchResult m_recordedResult = MatchResult::Running;
+
+    void advance();
+    void diverge(long long tick);
+};
+
+// Re-simulates a whole recording without a window.
+struct ReplayVerdict {
+    bool loaded;
+    std::string error;
+    long long ticks;
+    long long divergedAt;     // -1 when every checksum matched
+    bool complete;            // the recording has an End event
+    MatchResult recorded;
+    MatchResult replayed;
+};
+ReplayVerdict verifyReplay(const unsigned char *data, size_t size);
+
+#endif // REPLAY_H
@@ -0,0 +1,5 @@
+TARGET = replaycheck
+include(../game.pri)
+SOURCES += replaycheckmain.cpp
+CONFIG += console release c++17
+CONFIG -= qt app_bundle
@@ -0,0 +1,94 @@
+// Re-simulates recorded matches without a window and reports every replay
+// that no longer plays out the way it was recorded.
+//
+//   replaycheck [--verbose] PATH...
+//
+// A PATH may be a replay or a directory, which is searched for *.rpl files.
+// Exits with 1 when any replay diverged or could not be read.
+
+#include "mappedfile.h"
+#include "replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const char *resultName(MatchResult result) {
+    switch (result) {
+    case MatchResult::Victory: return "victory";
+    case MatchResult::DogStung: return "stung";
+    case MatchResult::InvalidHealth: return "invalid hp";
+    case MatchResult::Running: break;
+    }
+    return "running";
+}
+
+void collect(const filesystem::path &path, vector<string> &out) {
+    std::error_code ec;
+    if (!filesystem::is_directory(path, ec)) {
+        out.push_back(path.string());
+        return;
+    }
+    for (const auto &entry : filesystem::recursive_directory_iterator(path, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".rpl") {
+            out.push_back(entry.path().string());
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bool verbose = false;
+    vector<string> files;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--verbose")) verbose = true;
+        else collect(argv[i], files);
+    }
+    if (files.empty()) {
+        fprintf(stderr, "usage: %s [--verbose] PATH...\n", argv[0]);
+        return 2;
+    }
+
+    int passed = 0, diverged = 0, unreadable = 0, incomplete = 0;
+    long long ticks = 0;
+    auto start = chrono::steady_clock::now();
+    for (const string &path : files) {
+        MappedFile file;
+        if (!file.open(path)) {
+            printf("%s: cannot open file\n", path.c_str());
+            unreadable++;
+            continue;
+        }
+        ReplayVerdict v = verifyReplay(file.data(), file.size());
+        ticks += v.ticks;
+        if (!v.loaded) {
+            printf("%s: %s\n", path.c_str(), v.error.c_str());
+            unreadable++;
+        } else if (v.divergedAt >= 0) {
+            printf("%s: DIVERGED at tick %lld (recorded %s, replayed %s)\n", path.c_str(),
+                   v.divergedAt, resultName(v.recorded), resultName(v.replayed));
+            diverged++;
+        } else {
+            passed++;
+            if (!v.complete) incomplete++;
+            if (verbose) {
+                printf("%s: ok, %s after %lld ticks%s\n", path.c_str(), resultName(v.replayed),
+                       v.ticks, v.complete ? "" : " (abandoned)");
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%zu replays: %d ok (%d abandoned), %d diverged, %d unreadable\n",
+           files.size(), passed, incomplete, diverged, unreadable);
+    printf("%lld ticks in %.2f s (%.0f ticks/s)\n", ticks, seconds, ticks / max(seconds, 1e-9));
+    return diverged || unreadable ? 1 : 0;
+}
@@ -0,0 +1,67 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// splitmix64: turns one 64-bit value into a well mixed one and advances it.
+// Used to expand seeds and to derive per-match seeds from a base seed.
+inline uint64_t splitmix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// xoshiro256** generator. Small, fast and fully defined here, so the same
+// seed gives the same numbers on every compiler and platform (unlike rand()
+// or the std distributions). Not thread-safe; give every game its own.
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        uint64_t sm = seed;
+        for (uint64_t &word : m_state) {
+            word = splitmix64(sm);
+        }
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+        const uint64_t t = m_state[1] << 17;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 45);
+        return result;
+    }
+
+    // Uniform int in [lo, hi] without modulo bias (Lemire's method)
+    int range(int lo, int hi) {
+        const uint32_t span = static_cast<uint32_t>(static_cast<int64_t>(hi) - lo + 1);
+        if (span == 0) {
+            return lo + static_cast<int>(next() >> 32);  // full 32-bit range
+        }
+        uint64_t m = (next() >> 32) * span;
+        uint32_t low = static_cast<uint32_t>(m);
+        if (low < span) {
+            const uint32_t threshold = (0u - span) % span;
+            while (low < threshold) {
+                m = (next() >> 32) * span;
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return lo + static_cast<int>(m >> 32);
+    }
+
+private:
+    uint64_t m_state[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+#endif // RNG_H
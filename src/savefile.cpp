@@ -0,0 +1,203 @@
+#include "savefile.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char *SAVE_PATH = "save.dat";
+const char *TEMP_PATH = "save.dat.tmp";
+const char *BAD_PATH = "save.dat.bad";
+const char *LEGACY_PATH = "config.txt";
+const char *LEGACY_BACKUP_PATH = "config.txt.old";
+
+const char MAGIC[4] = {'S', 'D', 'S', 'V'};
+const uint32_t VERSION = 1;
+const uint32_t FIELD_COUNT = 4;
+const size_t SAVE_SIZE = 4 + 4 + 4 + FIELD_COUNT * 8 + 4;
+
+uint32_t crc32(const unsigned char *p, size_t n) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= p[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+void putU32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+void putU64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+uint32_t getU32(const unsigned char *p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+uint64_t getU64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+// Old config.txt: base64 of "auraxp;boughtblocks;boughthp;level"
+bool readLegacyConfig(datastorage &data) {
+    FILE *f = fopen(LEGACY_PATH, "rb");
+    if (!f) {
+        return false;
+    }
+    std::string encoded;
+    char buffer[256];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        encoded.append(buffer, n);
+    }
+    fclose(f);
+
+    std::string decoded;
+    int val = 0, valb = -8;
+    for (char c : encoded) {
+        int digit;
+        if (c >= 'A' && c <= 'Z') digit = c - 'A';
+        else if (c >= 'a' && c <= 'z') digit = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') digit = c - '0' + 52;
+        else if (c == '+') digit = 62;
+        else if (c == '/') digit = 63;
+        else if (c == '=') break;
+        else continue;
+        val = (val << 6) + digit;
+        valb += 6;
+        if (valb >= 0) {
+            decoded.push_back(static_cast<char>((val >> valb) & 0xFF));
+            valb -= 8;
+        }
+    }
+
+    unsigned long long fields[FIELD_COUNT];
+    const char *p = decoded.c_str();
+    for (uint32_t i = 0; i < FIELD_COUNT; i++) {
+        char *end;
+        fields[i] = strtoull(p, &end, 10);
+        const char expected = i + 1 < FIELD_COUNT ? ';' : '\0';
+        if (end == p || *end != expected) {
+            return false;
+        }
+        p = end + 1;
+    }
+    data.auraxp = fields[0];
+    data.boughtblocks = fields[1];
+    data.boughthp = fields[2];
+    data.level = fields[3];
+    return true;
+}
+
+bool replaceFile(const char *from, const char *to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+// A rename is only on disk once the directory holding it is. Windows
+// already writes it through in replaceFile().
+bool syncDirectory() {
+#ifdef _WIN32
+    return true;
+#else
+    const int dir = open(".", O_RDONLY);
+    if (dir < 0) {
+        return false;
+    }
+    const bool ok = fsync(dir) == 0;
+    close(dir);
+    return ok;
+#endif
+}
+
+} // namespace
+
+SaveStatus loadSave(datastorage &data) {
+    FILE *f = fopen(SAVE_PATH, "rb");
+    if (!f) {
+        if (!readLegacyConfig(data)) {
+            return SaveStatus::Missing;
+        }
+        if (writeSave(data)) {
+            replaceFile(LEGACY_PATH, LEGACY_BACKUP_PATH);
+        }
+        return SaveStatus::Migrated;
+    }
+
+    // One byte more than a save, to catch trailing junk
+    unsigned char buffer[SAVE_SIZE + 1];
+    const size_t n = fread(buffer, 1, sizeof(buffer), f);
+    fclose(f);
+    // A later version may have changed anything after the version field
+    if (n >= 8 && memcmp(buffer, MAGIC, 4) == 0 && getU32(buffer + 4) > VERSION) {
+        return SaveStatus::Newer;
+    }
+    if (n != SAVE_SIZE || memcmp(buffer, MAGIC, 4) != 0 ||
+        getU32(buffer + 4) != VERSION || getU32(buffer + 8) != FIELD_COUNT ||
+        getU32(buffer + SAVE_SIZE - 4) != crc32(buffer, SAVE_SIZE - 4)) {
+        return SaveStatus::Corrupt;
+    }
+
+    const unsigned char *fields = buffer + 12;
+    data.auraxp = getU64(fields);
+    data.boughtblocks = getU64(fields + 8);
+    data.boughthp = getU64(fields + 16);
+    data.level = getU64(fields + 24);
+    return SaveStatus::Loaded;
+}
+
+bool setAsideSave() {
+    return replaceFile(SAVE_PATH, BAD_PATH);
+}
+
+bool writeSave(const datastorage &data) {
+    unsigned char buffer[SAVE_SIZE];
+    memcpy(buffer, MAGIC, 4);
+    putU32(buffer + 4, VERSION);
+    putU32(buffer + 8, FIELD_COUNT);
+    putU64(buffer + 12, data.auraxp);
+    putU64(buffer + 20, data.boughtblocks);
+    putU64(buffer + 28, data.boughthp);
+    putU64(buffer + 36, data.level);
+    putU32(buffer + SAVE_SIZE - 4, crc32(buffer, SAVE_SIZE - 4));
+
+    FILE *f = fopen(TEMP_PATH, "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = fwrite(buffer, 1, SAVE_SIZE, f) == SAVE_SIZE && fflush(f) == 0;
+    // The rename must not reach the disk before the data does
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(f)) == 0;
+#else
+    ok = ok && fsync(fileno(f)) == 0;
+#endif
+    ok = fclose(f) == 0 && ok;
+    if (!ok || !replaceFile(TEMP_PATH, SAVE_PATH)) {
+        remove(TEMP_PATH);
+        return false;
+    }
+    return syncDirectory();
+}
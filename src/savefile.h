@@ -0,0 +1,29 @@
+#ifndef SAVEFILE_H
+#define SAVEFILE_H
+
+#include "defs.h"
+
+// Player progress (auraxp, boughtblocks, boughthp, level) in save.dat.
+//
+// Layout (little endian): "SDSV", u32 version, u32 field count, that many
+// u64 fields, u32 CRC-32 of everything before it. Saves go to a temp file
+// that is flushed to disk and then renamed over save.dat, so a crash leaves
+// either the old save or the new one, never half of each.
+
+enum class SaveStatus {
+    Loaded,
+    Migrated,  // came from the old base64 config.txt, now in save.dat
+    Missing,
+    Newer,     // written by a later version of the game; must not be overwritten
+    Corrupt
+};
+
+// One read of save.dat. Without one, an old config.txt is converted once.
+// data is only touched on Loaded and Migrated.
+SaveStatus loadSave(datastorage &data);
+bool writeSave(const datastorage &data);
+// Renames a corrupt save.dat to save.dat.bad, out of the way of a new one
+// but still there to be looked at
+bool setAsideSave();
+
+#endif // SAVEFILE_H
@@ -0,0 +1,31 @@
+#include "scheduler.h"
+#include <algorithm>
+
+namespace {
+
+// std heaps are max-heaps, so "less" means "fires later"
+bool firesLater(const Scheduler::Event &a, const Scheduler::Event &b) {
+    return a.tick != b.tick ? a.tick > b.tick : a.seq > b.seq;
+}
+
+} // namespace
+
+void Scheduler::clear() {
+    m_heap.clear();
+    m_nextSeq = 0;
+}
+
+void Scheduler::schedule(long long tick, int type) {
+    m_heap.push_back(Event{tick, m_nextSeq++, type});
+    std::push_heap(m_heap.begin(), m_heap.end(), firesLater);
+}
+
+bool Scheduler::popDue(long long tick, Event &out) {
+    if (m_heap.empty() || m_heap.front().tick > tick) {
+        return false;
+    }
+    std::pop_heap(m_heap.begin(), m_heap.end(), firesLater);
+    out = m_heap.back();
+    m_heap.pop_back();
+    return true;
+}
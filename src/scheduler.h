@@ -0,0 +1,31 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <vector>
+
+// Min-heap of events keyed by simulation tick. Events due on the same tick
+// come out in the order they were scheduled, so runs stay deterministic.
+class Scheduler {
+public:
+    struct Event {
+        long long tick;
+        unsigned seq;
+        int type;  // meaning is up to the owner
+    };
+
+    void clear();
+    void schedule(long long tick, int type);
+
+    // Pops the earliest event due at or before tick; false when none is due.
+    bool popDue(long long tick, Event &out);
+
+    bool empty() const { return m_heap.empty(); }
+    // Tick of the earliest event, or -1 when nothing is scheduled
+    long long nextTick() const { return m_heap.empty() ? -1 : m_heap.front().tick; }
+
+private:
+    std::vector<Event> m_heap;
+    unsigned m_nextSeq = 0;
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,205 @@
+#include "segmentbox.h"
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SEGMENTBOX_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SEGMENTBOX_SSE2
+#endif
+
+namespace {
+
+const float INF = std::numeric_limits<float>::infinity();
+
+// Narrows [tmin, tmax] to the part of the segment between lo and hi on one
+// axis. The SIMD kernels below do the same operations in the same order,
+// and game.pri keeps the compiler from fusing any of them.
+inline void clipAxis(float p, float d, float lo, float hi, float &tmin, float &tmax) {
+    float tnear, tfar;
+    if (d != 0) {
+        const float ta = (lo - p) / d;
+        const float tb = (hi - p) / d;
+        tnear = std::min(ta, tb);
+        tfar = std::max(ta, tb);
+    } else {
+        // Parallel to this slab: all in or all out
+        const bool inside = lo <= p && p <= hi;
+        tnear = inside ? -INF : INF;
+        tfar = inside ? INF : -INF;
+    }
+    tmin = std::max(tmin, tnear);
+    tmax = std::min(tmax, tfar);
+}
+
+size_t firstScalar(const float *x1, const float *y1, const float *x2, const float *y2,
+                   size_t begin, size_t count, const Box &box) {
+    for (size_t i = begin; i < count; ++i) {
+        if (segmentTouchesBox(x1[i], y1[i], x2[i], y2[i], box)) {
+            return i;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+bool segmentTouchesBox(float x1, float y1, float x2, float y2, const Box &box) {
+    float tmin = 0;
+    float tmax = 1;
+    clipAxis(x1, x2 - x1, box.left, box.right, tmin, tmax);
+    clipAxis(y1, y2 - y1, box.top, box.bottom, tmin, tmax);
+    return tmin <= tmax;
+}
+
+bool sweepBoxToSegment(float x1, float y1, float x2, float y2, const Box &box, float dx, float dy, float &t) {
+    if (segmentTouchesBox(x1, y1, x2, y2, box)) {
+        t = 0;
+        return true;
+    }
+    // The first contact is an endpoint entering the box or a corner of the
+    // box reaching the segment, whichever comes first
+    float first = INF;
+    const float px[2] = {x1, x2};
+    const float py[2] = {y1, y2};
+    for (int i = 0; i < 2; i++) {
+        // The box's motion seen from the endpoint
+        float tmin = 0;
+        float tmax = 1;
+        clipAxis(px[i], -dx, box.left, box.right, tmin, tmax);
+        clipAxis(py[i], -dy, box.top, box.bottom, tmin, tmax);
+        if (tmin <= tmax) {
+            first = std::min(first, tmin);
+        }
+    }
+    const float ex = x2 - x1;
+    const float ey = y2 - y1;
+    const float denom = dx * ey - dy * ex;
+    if (denom != 0) {
+        // Parallel motion touches an endpoint first, handled above
+        const float cx[4] = {box.left, box.right, box.left, box.right};
+        const float cy[4] = {box.top, box.top, box.bottom, box.bottom};
+        for (int i = 0; i < 4; i++) {
+            const float ox = x1 - cx[i];
+            const float oy = y1 - cy[i];
+            const float tc = (ox * ey - oy * ex) / denom;
+            const float u = (ox * dy - oy * dx) / denom;
+            if (tc >= 0 && tc <= 1 && u >= 0 && u <= 1) {
+                first = std::min(first, tc);
+            }
+        }
+    }
+    if (first > 1) {
+        return false;
+    }
+    t = first;
+    return true;
+}
+
+#if defined(SEGMENTBOX_AVX2)
+
+namespace {
+
+inline void clipAxis8(__m256 p, __m256 d, __m256 lo, __m256 hi, __m256 &tmin, __m256 &tmax) {
+    const __m256 inf = _mm256_set1_ps(INF);
+    const __m256 negInf = _mm256_set1_ps(-INF);
+    const __m256 ta = _mm256_div_ps(_mm256_sub_ps(lo, p), d);
+    const __m256 tb = _mm256_div_ps(_mm256_sub_ps(hi, p), d);
+    const __m256 inside = _mm256_and_ps(_mm256_cmp_ps(lo, p, _CMP_LE_OQ), _mm256_cmp_ps(p, hi, _CMP_LE_OQ));
+    const __m256 parallel = _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_EQ_OQ);
+    const __m256 tnear = _mm256_blendv_ps(_mm256_min_ps(ta, tb), _mm256_blendv_ps(inf, negInf, inside), parallel);
+    const __m256 tfar = _mm256_blendv_ps(_mm256_max_ps(ta, tb), _mm256_blendv_ps(negInf, inf, inside), parallel);
+    tmin = _mm256_max_ps(tmin, tnear);
+    tmax = _mm256_min_ps(tmax, tfar);
+}
+
+} // namespace
+
+size_t firstSegmentTouchingBox(const float *x1, const float *y1, const float *x2, const float *y2,
+                               size_t count, const Box &box) {
+    const __m256 left = _mm256_set1_ps(box.left);
+    const __m256 top = _mm256_set1_ps(box.top);
+    const __m256 right = _mm256_set1_ps(box.right);
+    const __m256 bottom = _mm256_set1_ps(box.bottom);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 px = _mm256_loadu_ps(x1 + i);
+        const __m256 py = _mm256_loadu_ps(y1 + i);
+        const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x2 + i), px);
+        const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y2 + i), py);
+        __m256 tmin = _mm256_setzero_ps();
+        __m256 tmax = _mm256_set1_ps(1);
+        clipAxis8(px, dx, left, right, tmin, tmax);
+        clipAxis8(py, dy, top, bottom, tmin, tmax);
+        const int hits = _mm256_movemask_ps(_mm256_cmp_ps(tmin, tmax, _CMP_LE_OQ));
+        if (hits) {
+            int lane = 0;
+            while (!(hits & (1 << lane))) lane++;
+            return i + lane;
+        }
+    }
+    return firstScalar(x1, y1, x2, y2, i, count, box);
+}
+
+#elif defined(SEGMENTBOX_SSE2)
+
+namespace {
+
+// SSE2 has no blendv, pick b where mask is set
+inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+}
+
+inline void clipAxis4(__m128 p, __m128 d, __m128 lo, __m128 hi, __m128 &tmin, __m128 &tmax) {
+    const __m128 inf = _mm_set1_ps(INF);
+    const __m128 negInf = _mm_set1_ps(-INF);
+    const __m128 ta = _mm_div_ps(_mm_sub_ps(lo, p), d);
+    const __m128 tb = _mm_div_ps(_mm_sub_ps(hi, p), d);
+    const __m128 inside = _mm_and_ps(_mm_cmple_ps(lo, p), _mm_cmple_ps(p, hi));
+    const __m128 parallel = _mm_cmpeq_ps(d, _mm_setzero_ps());
+    const __m128 tnear = select(parallel, _mm_min_ps(ta, tb), select(inside, inf, negInf));
+    const __m128 tfar = select(parallel, _mm_max_ps(ta, tb), select(inside, negInf, inf));
+    tmin = _mm_max_ps(tmin, tnear);
+    tmax = _mm_min_ps(tmax, tfar);
+}
+
+} // namespace
+
+size_t firstSegmentTouchingBox(const float *x1, const float *y1, const float *x2, const float *y2,
+                               size_t count, const Box &box) {
+    const __m128 left = _mm_set1_ps(box.left);
+    const __m128 top = _mm_set1_ps(box.top);
+    const __m128 right = _mm_set1_ps(box.right);
+    const __m128 bottom = _mm_set1_ps(box.bottom);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 px = _mm_loadu_ps(x1 + i);
+        const __m128 py = _mm_loadu_ps(y1 + i);
+        const __m128 dx = _mm_sub_ps(_mm_loadu_ps(x2 + i), px);
+        const __m128 dy = _mm_sub_ps(_mm_loadu_ps(y2 + i), py);
+        __m128 tmin = _mm_setzero_ps();
+        __m128 tmax = _mm_set1_ps(1);
+        clipAxis4(px, dx, left, right, tmin, tmax);
+        clipAxis4(py, dy, top, bottom, tmin, tmax);
+        const int hits = _mm_movemask_ps(_mm_cmple_ps(tmin, tmax));
+        if (hits) {
+            int lane = 0;
+            while (!(hits & (1 << lane))) lane++;
+            return i + lane;
+        }
+    }
+    return firstScalar(x1, y1, x2, y2, i, count, box);
+}
+
+#else
+
+size_t firstSegmentTouchingBox(const float *x1, const float *y1, const float *x2, const float *y2,
+                               size_t count, const Box &box) {
+    return firstScalar(x1, y1, x2, y2, 0, count, box);
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SEGMENTBOX_H
+#define SEGMENTBOX_H
+
+#include <cstddef>
+#include <vector>
+
+// Closed axis-aligned box; right and bottom are inclusive like QRect's.
+struct Box {
+    float left;
+    float top;
+    float right;
+    float bottom;
+};
+
+// Segments as four packed float arrays, the layout the batch test reads.
+struct SegmentArray {
+    std::vector<float> x1, y1, x2, y2;
+
+    void clear() { x1.clear(); y1.clear(); x2.clear(); y2.clear(); }
+    void reserve(size_t n) { x1.reserve(n); y1.reserve(n); x2.reserve(n); y2.reserve(n); }
+    void push(float ax, float ay, float bx, float by) {
+        x1.push_back(ax);
+        y1.push_back(ay);
+        x2.push_back(bx);
+        y2.push_back(by);
+    }
+    void push(const SegmentArray &from, size_t i) { push(from.x1[i], from.y1[i], from.x2[i], from.y2[i]); }
+    void set(size_t i, float ax, float ay, float bx, float by) {
+        x1[i] = ax;
+        y1[i] = ay;
+        x2[i] = bx;
+        y2[i] = by;
+    }
+    size_t size() const { return x1.size(); }
+};
+
+// True when any point of the segment lies inside or on the box, so a
+// segment wholly inside the box counts too. Liang-Barsky slab clipping:
+// no intersection points, no edge segments, four divisions.
+bool segmentTouchesBox(float x1, float y1, float x2, float y2, const Box &box);
+
+// The box moved by t times (dx, dy) for t in [0, 1]: the smallest t at which
+// it touches the segment, 0 if it already does. False if it never does.
+bool sweepBoxToSegment(float x1, float y1, float x2, float y2, const Box &box, float dx, float dy, float &t);
+
+// Tests one box against count packed segments and returns the index of the
+// first one touching it, or count when none does. Uses AVX2 or SSE2 when the
+// compiler targets them, with the same results as segmentTouchesBox().
+size_t firstSegmentTouchingBox(const float *x1, const float *y1, const float *x2, const float *y2,
+                               size_t count, const Box &box);
+
+#endif // SEGMENTBOX_H
@@ -0,0 +1,25 @@
+#include "simsnapshot.h"
+
+void SimSnapshot::capture(const GameSimulation &sim) {
+    cols = sim.cols();
+    rows = sim.rows();
+    width = sim.width();
+    height = sim.height();
+    spacing = sim.spacing();
+    tick = sim.tick();
+    countdownSeconds = sim.countdownSeconds();
+    dogPos = sim.dogPos();
+    bees = sim.bees();
+    lines = sim.lines();
+    lineHandles.resize(lines.size());
+    for (size_t i = 0; i < lines.size(); i++) {
+        lineHandles[i] = sim.lineHandle(i);
+    }
+    result = sim.result();
+    xpReward = sim.xpReward();
+    const datastorage &data = sim.gameData();
+    blocks = data.blocks;
+    hp = data.current_hp;
+    level = data.level;
+    auraxp = data.auraxp;
+}
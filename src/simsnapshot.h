@@ -0,0 +1,44 @@
+#ifndef SIMSNAPSHOT_H
+#define SIMSNAPSHOT_H
+
+#include "beearray.h"
+#include "gamesimulation.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Everything the window shows of one simulation state, copied out so it can
+// be painted while the simulation carries on elsewhere.
+struct SimSnapshot {
+    int cols = 0;
+    int rows = 0;
+    int width = 0;
+    int height = 0;
+    int spacing = 0;
+    long long tick = 0;
+    std::chrono::steady_clock::time_point tickTime;  // when tick was due, if paced
+    int countdownSeconds = 0;
+    SimPoint dogPos{0, 0};
+    BeeArray bees;  // with their handles, so a bee can be followed between frames
+    std::vector<Line> lines;
+    std::vector<Handle> lineHandles;  // per line
+    MatchResult result = MatchResult::Running;
+    int xpReward = 0;
+    unsigned long long blocks = 0;
+    unsigned long long hp = 0;
+    unsigned long long level = 0;
+    unsigned long long auraxp = 0;
+    long long replayDivergedAt = -1;
+
+    // Reuses the vectors' storage, so steady capturing does not allocate
+    void capture(const GameSimulation &sim);
+
+    SimPoint toPixel(SimPoint lattice) const {
+        return SimPoint{MARGIN + lattice.x * spacing, MARGIN + lattice.y * spacing};
+    }
+    SimPoint toLattice(SimPoint pixel) const {
+        return SimPoint{(pixel.x - MARGIN) / spacing, (pixel.y - MARGIN) / spacing};
+    }
+};
+
+#endif // SIMSNAPSHOT_H
@@ -0,0 +1,142 @@
+#include "simthread.h"
+
+using Clock = std::chrono::steady_clock;
+
+SimThread::SimThread(datastorage &gameData, uint64_t seed, const SimParams &params)
+    : m_sim(gameData, seed, params), m_seed(seed), m_replay(nullptr), m_speed(1),
+      m_tickTime(Clock::now()), m_inputPending(false), m_stopping(false) {
+    m_recorder.begin(m_sim);
+    // The window needs a first state before the thread is running
+    publish();
+}
+
+SimThread::~SimThread() {
+    stop();
+}
+
+void SimThread::playReplay(ReplayPlayer *player, double speed) {
+    m_replay = player;
+    m_speed = speed;
+}
+
+void SimThread::reset(uint64_t seed) {
+    // The thread is joined, nothing else touches the queues or the sim
+    m_seed = seed;
+    m_sim.reset(seed);
+    m_replay = nullptr;
+    m_speed = 1;
+    m_tickTime = Clock::now();
+    m_inputPending = false;
+    PlaceCommand command;
+    while (m_commands.pop(command)) {
+    }
+    PlaceResult result;
+    while (m_results.pop(result)) {
+    }
+    m_recorder.begin(m_sim);
+    publish();
+}
+
+void SimThread::start() {
+    if (!m_thread.joinable()) {
+        m_stopping = false;
+        m_thread = std::thread(&SimThread::run, this);
+    }
+}
+
+void SimThread::stop() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+bool SimThread::placeLine(SimPoint a, SimPoint b) {
+    if (!m_commands.push(PlaceCommand{a, b})) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_inputPending = true;
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+void SimThread::run() {
+    const Clock::duration tickLength = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(1000.0 / GameSimulation::TICKS_PER_SECOND / m_speed));
+    Clock::time_point due = Clock::now() + tickLength;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            auto woken = [this] { return m_stopping || m_inputPending; };
+            if (m_sim.result() == MatchResult::Running) {
+                m_wake.wait_until(lock, due, woken);
+            } else {
+                m_wake.wait(lock, woken);
+            }
+            if (m_stopping) {
+                return;
+            }
+            m_inputPending = false;
+        }
+
+        bool changed = applyInput();
+
+        // A stall (debugger, suspended machine) is skipped rather than caught up on
+        const Clock::time_point now = Clock::now();
+        if (now - due > std::chrono::milliseconds(250)) {
+            due = now;
+        }
+        while (due <= now && m_sim.result() == MatchResult::Running) {
+            m_tickTime = due;
+            tickOnce();
+            due += tickLength;
+            changed = true;
+        }
+        if (changed) {
+            publish();
+        }
+    }
+}
+
+bool SimThread::applyInput() {
+    bool changed = false;
+    PlaceCommand command;
+    while (m_commands.pop(command)) {
+        const PlaceResult result = m_sim.placeLine(command.a, command.b);
+        if (result == PlaceResult::Placed) {
+            m_recorder.placed(m_sim, command.a, command.b);
+            changed = true;
+        }
+        m_results.push(result);
+    }
+    return changed;
+}
+
+void SimThread::tickOnce() {
+    if (m_replay) {
+        m_replay->applyInput(m_sim);
+    }
+    m_sim.step();
+    if (m_replay) {
+        m_replay->check(m_sim);
+    } else {
+        m_recorder.ticked(m_sim);
+    }
+}
+
+void SimThread::publish() {
+    SimSnapshot &snapshot = m_snapshots.back();
+    snapshot.capture(m_sim);
+    snapshot.tickTime = m_tickTime;
+    snapshot.replayDivergedAt = m_replay ? m_replay->divergedAt() : -1;
+    m_snapshots.publish();
+}
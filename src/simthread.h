@@ -0,0 +1,76 @@
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+#include "gamesimulation.h"
+#include "replay.h"
+#include "simsnapshot.h"
+#include "spscqueue.h"
+#include "triplebuffer.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Runs a GameSimulation in real time on a thread of its own. After every
+// tick (and every placed line) the state is copied into a snapshot; the
+// window picks up the newest one whenever it paints and never waits for a
+// tick to finish. Player input goes the other way through a queue and is
+// applied between ticks, as it always has been.
+class SimThread {
+public:
+    SimThread(datastorage &gameData, uint64_t seed, const SimParams &params);
+    ~SimThread();
+
+    // Before start(): play a recording instead of taking input. speed 1 is
+    // real time.
+    void playReplay(ReplayPlayer *player, double speed);
+    // While stopped: a new match with this seed, from gameData as it is
+    // now, taking player input again
+    void reset(uint64_t seed);
+    void start();
+    // Joins the thread; gameData and recording() are safe to use after it
+    void stop();
+
+    uint64_t seed() const { return m_seed; }
+    const ReplayRecorder &recording() const { return m_recorder; }
+
+    // Caller's thread (the window). refresh() takes over the newest
+    // snapshot, state() stays valid and unchanged until the next refresh().
+    bool refresh() { return m_snapshots.acquire(); }
+    const SimSnapshot &state() const { return m_snapshots.front(); }
+    // Endpoints are lattice coordinates. False if too many are still queued.
+    bool placeLine(SimPoint a, SimPoint b);
+    // Outcome of each queued line, in order
+    bool placeResult(PlaceResult &result) { return m_results.pop(result); }
+
+private:
+    struct PlaceCommand {
+        SimPoint a;
+        SimPoint b;
+    };
+
+    GameSimulation m_sim;
+    uint64_t m_seed;
+    ReplayRecorder m_recorder;
+    ReplayPlayer *m_replay;
+    double m_speed;
+    std::chrono::steady_clock::time_point m_tickTime;
+
+    TripleBuffer<SimSnapshot> m_snapshots;
+    SpscQueue<PlaceCommand, 64> m_commands;
+    SpscQueue<PlaceResult, 64> m_results;
+
+    // Only wakes the thread early for input; the data goes through the queues
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    bool m_inputPending;
+    bool m_stopping;
+    std::thread m_thread;
+
+    void run();
+    bool applyInput();
+    void tickOnce();
+    void publish();
+};
+
+#endif // SIMTHREAD_H
@@ -0,0 +1,32 @@
+#include "slotallocator.h"
+
+void SlotAllocator::clear() {
+    // Generations restart too: handles do not outlive a reset
+    m_generation.clear();
+    m_live.clear();
+    m_free.clear();
+}
+
+void SlotAllocator::reserve(size_t n) {
+    m_generation.reserve(n);
+    m_live.reserve(n);
+    m_free.reserve(n);
+}
+
+uint32_t SlotAllocator::allocate() {
+    if (!m_free.empty()) {
+        const uint32_t slot = m_free.back();
+        m_free.pop_back();
+        m_live[slot] = 1;
+        return slot;
+    }
+    m_generation.push_back(0);
+    m_live.push_back(1);
+    return static_cast<uint32_t>(m_generation.size() - 1);
+}
+
+void SlotAllocator::release(uint32_t slot) {
+    m_live[slot] = 0;
+    m_generation[slot]++;
+    m_free.push_back(slot);
+}
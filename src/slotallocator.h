@@ -0,0 +1,42 @@
+#ifndef SLOTALLOCATOR_H
+#define SLOTALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Names an entry of a pool for as long as it lives. Freeing the entry moves
+// its slot to the next generation, so an old handle stops matching instead
+// of finding whatever reused the slot.
+struct Handle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const Handle &o) const { return slot == o.slot && generation == o.generation; }
+    bool operator!=(const Handle &o) const { return !(*this == o); }
+};
+
+// Slot numbers for a pool: freed slots are handed out again (most recently
+// freed first) before the pool grows, so its arrays stay as large as the
+// most entries alive at once rather than all there ever were.
+class SlotAllocator {
+public:
+    void clear();
+    void reserve(size_t n);
+
+    uint32_t allocate();
+    void release(uint32_t slot);
+
+    // Slots handed out so far, live or free
+    size_t capacity() const { return m_generation.size(); }
+    bool live(uint32_t slot) const { return slot < m_live.size() && m_live[slot]; }
+    Handle handle(uint32_t slot) const { return Handle{slot, m_generation[slot]}; }
+    bool valid(Handle h) const { return live(h.slot) && m_generation[h.slot] == h.generation; }
+
+private:
+    std::vector<uint32_t> m_generation;
+    std::vector<unsigned char> m_live;
+    std::vector<uint32_t> m_free;
+};
+
+#endif // SLOTALLOCATOR_H
@@ -0,0 +1,128 @@
+#include "spatialgrid.h"
+#include <algorithm>
+
+namespace {
+// Shapes are registered one pixel fat so anything lying exactly on a cell
+// border lands in both neighbours.
+const int CELL_PAD = 1;
+}
+
+SpatialGrid::SpatialGrid()
+    : m_cols(0), m_rows(0), m_cellSize(1), m_originX(0), m_originY(0), m_queryStamp(0) {
+}
+
+void SpatialGrid::reset(int cols, int rows, int cellSize, int originX, int originY) {
+    m_cols = std::max(cols, 1);
+    m_rows = std::max(rows, 1);
+    m_cellSize = std::max(cellSize, 1);
+    m_originX = originX;
+    m_originY = originY;
+    m_cells.assign(static_cast<size_t>(m_cols) * m_rows, std::vector<int>());
+    m_seen.clear();
+    m_queryStamp = 0;
+}
+
+void SpatialGrid::clear() {
+    for (auto &cell : m_cells) {
+        cell.clear();
+    }
+}
+
+int SpatialGrid::cellOf(int pos, int origin) const {
+    int offset = pos - origin;
+    // Floor division, positions left of or above the origin are negative
+    return offset >= 0 ? offset / m_cellSize : -((-offset + m_cellSize - 1) / m_cellSize);
+}
+
+template <typename Fn>
+void SpatialGrid::forBoxCells(int left, int top, int right, int bottom, Fn fn) {
+    int c0 = cellOf(left - CELL_PAD, m_originX);
+    int c1 = cellOf(right + CELL_PAD, m_originX);
+    int r0 = cellOf(top - CELL_PAD, m_originY);
+    int r1 = cellOf(bottom + CELL_PAD, m_originY);
+    if (c1 < 0 || r1 < 0 || c0 >= m_cols || r0 >= m_rows) {
+        return;
+    }
+    c0 = std::max(c0, 0);
+    r0 = std::max(r0, 0);
+    c1 = std::min(c1, m_cols - 1);
+    r1 = std::min(r1, m_rows - 1);
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            fn(r * m_cols + c);
+        }
+    }
+}
+
+template <typename Fn>
+void SpatialGrid::forSegmentCells(int x1, int y1, int x2, int y2, Fn fn) {
+    if (y1 > y2) {
+        std::swap(x1, x2);
+        std::swap(y1, y2);
+    }
+    int r0 = std::max(cellOf(y1 - CELL_PAD, m_originY), 0);
+    int r1 = std::min(cellOf(y2 + CELL_PAD, m_originY), m_rows - 1);
+
+    // Walk the rows the segment spans and take the x extent inside each one
+    for (int r = r0; r <= r1; ++r) {
+        double slabTop = std::max<double>(m_originY + r * m_cellSize - CELL_PAD, y1);
+        double slabBottom = std::min<double>(m_originY + (r + 1) * m_cellSize + CELL_PAD, y2);
+        double xa = x1, xb = x2;
+        if (y2 != y1) {
+            double slope = static_cast<double>(x2 - x1) / (y2 - y1);
+            xa = x1 + (slabTop - y1) * slope;
+            xb = x1 + (slabBottom - y1) * slope;
+        }
+        int c0 = std::max(cellOf(static_cast<int>(std::min(xa, xb)) - CELL_PAD, m_originX), 0);
+        int c1 = std::min(cellOf(static_cast<int>(std::max(xa, xb)) + 1 + CELL_PAD, m_originX), m_cols - 1);
+        for (int c = c0; c <= c1; ++c) {
+            fn(r * m_cols + c);
+        }
+    }
+}
+
+void SpatialGrid::insertBox(int id, int left, int top, int right, int bottom) {
+    forBoxCells(left, top, right, bottom, [&](int cell) { m_cells[cell].push_back(id); });
+}
+
+void SpatialGrid::insertSegment(int id, int x1, int y1, int x2, int y2) {
+    forSegmentCells(x1, y1, x2, y2, [&](int cell) { m_cells[cell].push_back(id); });
+}
+
+void SpatialGrid::removeSegment(int id, int x1, int y1, int x2, int y2) {
+    forSegmentCells(x1, y1, x2, y2, [&](int cell) {
+        std::vector<int> &ids = m_cells[cell];
+        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+    });
+}
+
+void SpatialGrid::beginQuery() {
+    if (++m_queryStamp == 0) {
+        std::fill(m_seen.begin(), m_seen.end(), 0u);
+        m_queryStamp = 1;
+    }
+}
+
+void SpatialGrid::collect(int cellIndex, std::vector<int> &out) {
+    for (int id : m_cells[cellIndex]) {
+        if (static_cast<size_t>(id) >= m_seen.size()) {
+            m_seen.resize(id + 1, 0u);
+        }
+        if (m_seen[id] != m_queryStamp) {
+            m_seen[id] = m_queryStamp;
+            out.push_back(id);
+        }
+    }
+}
+
+void SpatialGrid::queryBox(int left, int top, int right, int bottom, std::vector<int> &out) {
+    out.clear();
+    beginQuery();
+    forBoxCells(left, top, right, bottom, [&](int cell) { collect(cell, out); });
+}
+
+void SpatialGrid::querySegment(int x1, int y1, int x2, int y2, std::vector<int> &out) {
+    out.clear();
+    beginQuery();
+    forSegmentCells(x1, y1, x2, y2, [&](int cell) { collect(cell, out); });
+}
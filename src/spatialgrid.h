@@ -0,0 +1,43 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <vector>
+
+// Uniform bucket grid laid over the playfield lattice. Cell (cx, cy) covers
+// the square between lattice points (cx, cy) and (cx+1, cy+1). Ids are small
+// non-negative ints (indices into the owner's arrays).
+class SpatialGrid {
+public:
+    SpatialGrid();
+
+    void reset(int cols, int rows, int cellSize, int originX, int originY);
+    void clear();
+
+    void insertBox(int id, int left, int top, int right, int bottom);
+    void insertSegment(int id, int x1, int y1, int x2, int y2);
+    void removeSegment(int id, int x1, int y1, int x2, int y2);
+
+    // Collects every id registered in a cell the shape overlaps, each once.
+    void queryBox(int left, int top, int right, int bottom, std::vector<int> &out);
+    void querySegment(int x1, int y1, int x2, int y2, std::vector<int> &out);
+
+private:
+    int m_cols;
+    int m_rows;
+    int m_cellSize;
+    int m_originX;
+    int m_originY;
+    std::vector<std::vector<int>> m_cells;
+
+    // Per-id stamp so a query reports an id once even if it spans cells
+    std::vector<unsigned> m_seen;
+    unsigned m_queryStamp;
+
+    int cellOf(int pos, int origin) const;
+    template <typename Fn> void forBoxCells(int left, int top, int right, int bottom, Fn fn);
+    template <typename Fn> void forSegmentCells(int x1, int y1, int x2, int y2, Fn fn);
+    void beginQuery();
+    void collect(int cellIndex, std::vector<int> &out);
+};
+
+#endif // SPATIALGRID_H
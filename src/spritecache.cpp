@@ -0,0 +1,45 @@
+#include "spritecache.h"
+
+QSize SpriteCache::drawSize(Sprite sprite) {
+    return sprite == Dog ? QSize(128, 128) : QSize(64, 64);
+}
+
+void SpriteCache::setSource(Sprite sprite, const QPixmap &source) {
+    m_sources[sprite] = source;
+    m_scaled[sprite].clear();
+}
+
+void SpriteCache::setSource(Sprite sprite, const QImage &source, const QImage &scaled, qreal dpr) {
+    setSource(sprite, QPixmap::fromImage(source));
+    if (!scaled.isNull()) {
+        Entry entry;
+        entry.size = drawSize(sprite);
+        entry.dpr = dpr;
+        entry.pixmap = QPixmap::fromImage(scaled);
+        entry.pixmap.setDevicePixelRatio(dpr);
+        m_scaled[sprite].push_back(entry);
+    }
+}
+
+QPixmap SpriteCache::pixmap(Sprite sprite, const QSize &size, qreal dpr) {
+    std::vector<Entry> &entries = m_scaled[sprite];
+    for (const Entry &entry : entries) {
+        if (entry.size == size && entry.dpr == dpr) {
+            return entry.pixmap;
+        }
+    }
+
+    // Zooming asks for a new scale now and then; keep the most recent few
+    if (entries.size() >= MAX_SCALES) {
+        entries.erase(entries.begin());
+    }
+    Entry entry;
+    entry.size = size;
+    entry.dpr = dpr;
+    if (!m_sources[sprite].isNull()) {
+        entry.pixmap = m_sources[sprite].scaled(size * dpr, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        entry.pixmap.setDevicePixelRatio(dpr);
+    }
+    entries.push_back(entry);
+    return entries.back().pixmap;
+}
@@ -0,0 +1,45 @@
+#ifndef SPRITECACHE_H
+#define SPRITECACHE_H
+
+#include <QImage>
+#include <QPixmap>
+#include <QSize>
+#include <vector>
+
+// Keeps the game sprites pre-scaled to the sizes they are drawn at, per
+// device pixel ratio, so painting never rescales the source images.
+class SpriteCache {
+public:
+    enum Sprite {
+        Dog,
+        Bee,
+        SpriteCount
+    };
+
+    // Logical pixels the game draws the sprite at, unzoomed
+    static QSize drawSize(Sprite sprite);
+
+    void setSource(Sprite sprite, const QPixmap &source);
+    // With a copy already scaled to drawSize() at dpr, which is then never
+    // scaled again
+    void setSource(Sprite sprite, const QImage &source, const QImage &scaled, qreal dpr);
+
+    // Pixmap of size * dpr device pixels with its device pixel ratio set,
+    // i.e. size logical pixels when drawn without scaling. A shared copy,
+    // so it stays valid when later calls add or evict scales.
+    QPixmap pixmap(Sprite sprite, const QSize &size, qreal dpr);
+
+private:
+    static const size_t MAX_SCALES = 8;
+
+    struct Entry {
+        QSize size;
+        qreal dpr;
+        QPixmap pixmap;
+    };
+
+    QPixmap m_sources[SpriteCount];
+    std::vector<Entry> m_scaled[SpriteCount];
+};
+
+#endif // SPRITECACHE_H
@@ -0,0 +1,28 @@
+#include "spriteloader.h"
+
+namespace {
+
+const char *const SPRITE_FILES[SpriteCache::SpriteCount] = {":/doghead.png", ":/bee.png"};
+
+SpriteImages decodeSprites(qreal dpr) {
+    // QImage, unlike QPixmap, may be made off the GUI thread. Premultiplied
+    // is what the raster paint engine draws, so the pixmaps made from these
+    // need no conversion.
+    SpriteImages images;
+    images.dpr = dpr;
+    for (int s = 0; s < SpriteCache::SpriteCount; s++) {
+        const SpriteCache::Sprite sprite = static_cast<SpriteCache::Sprite>(s);
+        images.source[s] = QImage(SPRITE_FILES[s]).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        if (!images.source[s].isNull()) {
+            images.scaled[s] = images.source[s].scaled(SpriteCache::drawSize(sprite) * dpr, Qt::IgnoreAspectRatio,
+                                                       Qt::SmoothTransformation);
+        }
+    }
+    return images;
+}
+
+} // namespace
+
+std::shared_future<SpriteImages> loadSprites(qreal dpr) {
+    return std::async(std::launch::async, decodeSprites, dpr).share();
+}
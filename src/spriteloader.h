@@ -0,0 +1,20 @@
+#ifndef SPRITELOADER_H
+#define SPRITELOADER_H
+
+#include "spritecache.h"
+#include <QImage>
+#include <future>
+
+// The game's sprites, decoded from the copies compiled in with assets.qrc
+struct SpriteImages {
+    QImage source[SpriteCache::SpriteCount];
+    // source at SpriteCache::drawSize() for this dpr, ready to draw
+    QImage scaled[SpriteCache::SpriteCount];
+    qreal dpr = 1;
+};
+
+// Decodes and scales on a thread of its own. Call at startup; the first
+// window to need the sprites waits only if that is not done yet.
+std::shared_future<SpriteImages> loadSprites(qreal dpr);
+
+#endif // SPRITELOADER_H
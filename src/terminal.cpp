@@ -0,0 +1,226 @@
+#include "terminal.h"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <conio.h>
+#else
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char *const HIDE_CURSOR = "\033[?25l";
+const char *const SHOW_CURSOR = "\033[?25h";
+const char *const CLEAR_SCREEN = "\033[H\033[2J";
+const char *const CLEAR_LINE_END = "\033[K";
+const char *const CLEAR_BELOW = "\033[J";
+const char ESCAPE = '\033';
+
+void write(const std::string &s) {
+    fwrite(s.data(), 1, s.size(), stdout);
+    fflush(stdout);
+}
+
+std::string moveTo(size_t row) {
+    return "\033[" + std::to_string(row + 1) + ";1H";
+}
+
+// Left over from typing a choice and ENTER out of habit
+bool ignored(char c) {
+    return c == '\n' || c == '\r' || c == ' ' || c == ESCAPE;
+}
+
+} // namespace
+
+#ifdef _WIN32
+
+namespace {
+const int CTRL_Z = 26;   // end of input typed at a console
+}
+
+Terminal::Terminal()
+    : m_fresh(true), m_closed(false), m_outputMode(0), m_console(false) {
+    // Raw keys come from _getch(); escape sequences need turning on.
+    // The console keeps its own mode, nothing to undo on Ctrl+C.
+    DWORD mode = 0;
+    m_console = GetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), &mode) != 0;
+    HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (GetConsoleMode(out, &mode)) {
+        m_outputMode = mode;
+        SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    }
+}
+
+Terminal::~Terminal() {
+    clear();
+    if (m_outputMode) {
+        SetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE), m_outputMode);
+    }
+}
+
+bool Terminal::readKey(char &key, int timeoutMs) {
+    if (!m_console) {
+        // _kbhit() only sees the console, so a pipe is read as it comes
+        int c;
+        while (!m_closed && (c = getchar()) != EOF) {
+            if (!ignored(static_cast<char>(c))) {
+                key = static_cast<char>(c);
+                return true;
+            }
+        }
+        m_closed = true;
+        return false;
+    }
+
+    // The console handle is signalled for mouse and focus events too, so
+    // poll for key presses instead
+    const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+        while (_kbhit()) {
+            const int c = _getch();
+            if (c == 0 || c == 0xE0) {
+                _getch();   // arrows and function keys come as two codes
+                continue;
+            }
+            if (c == CTRL_Z) {
+                m_closed = true;
+                return false;
+            }
+            if (ignored(static_cast<char>(c))) {
+                continue;
+            }
+            key = static_cast<char>(c);
+            return true;
+        }
+        if (timeoutMs >= 0 && std::chrono::steady_clock::now() >= until) {
+            return false;
+        }
+        Sleep(10);
+    }
+}
+
+void Terminal::discardInput() {
+    if (m_console) {
+        FlushConsoleInputBuffer(GetStdHandle(STD_INPUT_HANDLE));
+    }
+}
+
+#else
+
+namespace {
+
+// The mode to put back. File scope, because a signal or exit() ends the
+// process without running ~Terminal().
+termios savedMode;
+volatile sig_atomic_t rawMode = 0;
+const int RESTORE_SIGNALS[] = {SIGINT, SIGTERM, SIGHUP, SIGQUIT};
+
+// Async-signal-safe: tcsetattr() and write() only
+void restoreMode() {
+    if (rawMode) {
+        rawMode = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &savedMode);
+        const char show[] = "\033[?25h";
+        ssize_t written = ::write(STDOUT_FILENO, show, sizeof(show) - 1);
+        (void)written;
+    }
+}
+
+void restoreAndDie(int sig) {
+    restoreMode();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+} // namespace
+
+Terminal::Terminal()
+    : m_fresh(true), m_closed(false) {
+    // Keys as they are pressed, unechoed; Ctrl+C still interrupts, and
+    // puts the shell's mode back on the way out like a normal exit does
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &savedMode) == 0) {
+        termios raw = savedMode;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        static bool hooked = false;
+        if (!hooked) {
+            hooked = true;
+            atexit(restoreMode);
+            for (int sig : RESTORE_SIGNALS) {
+                signal(sig, restoreAndDie);
+            }
+        }
+        rawMode = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+    }
+}
+
+Terminal::~Terminal() {
+    clear();
+    restoreMode();
+}
+
+bool Terminal::readKey(char &key, int timeoutMs) {
+    while (!m_closed) {
+        pollfd in{STDIN_FILENO, POLLIN, 0};
+        if (poll(&in, 1, timeoutMs) <= 0) {
+            return false;
+        }
+        char c;
+        if (read(STDIN_FILENO, &c, 1) != 1) {
+            m_closed = true;
+            return false;
+        }
+        if (c == ESCAPE) {
+            // Arrows and function keys: drop the rest of the sequence
+            char rest[16];
+            while (poll(&in, 1, 0) > 0 && read(STDIN_FILENO, rest, sizeof(rest)) > 0) {
+            }
+            continue;
+        }
+        if (ignored(c)) {
+            continue;
+        }
+        key = c;
+        return true;
+    }
+    return false;
+}
+
+void Terminal::discardInput() {
+    if (isatty(STDIN_FILENO)) {
+        tcflush(STDIN_FILENO, TCIFLUSH);
+    }
+}
+
+#endif
+
+void Terminal::draw(const std::vector<std::string> &lines) {
+    std::string out = HIDE_CURSOR;
+    if (m_fresh) {
+        out += CLEAR_SCREEN;
+        m_shown.clear();
+        m_fresh = false;
+    }
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (i >= m_shown.size() || m_shown[i] != lines[i]) {
+            out += moveTo(i) + lines[i] + CLEAR_LINE_END;
+        }
+    }
+    if (lines.size() < m_shown.size()) {
+        out += moveTo(lines.size()) + CLEAR_BELOW;
+    }
+    m_shown = lines;
+    write(out);
+}
+
+void Terminal::clear() {
+    write(std::string(CLEAR_SCREEN) + SHOW_CURSOR);
+    m_shown.clear();
+    m_fresh = true;
+}
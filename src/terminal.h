@@ -0,0 +1,44 @@
+#ifndef TERMINAL_H
+#define TERMINAL_H
+
+#include <string>
+#include <vector>
+
+// The console side of the game: keys are read one at a time as they are
+// pressed, without echo or ENTER, and screens are drawn with ANSI escape
+// sequences in place, rewriting only the lines that changed since the last
+// one. Nothing forks a shell to clear the screen.
+class Terminal {
+public:
+    Terminal();
+    ~Terminal();
+    Terminal(const Terminal &) = delete;
+    Terminal &operator=(const Terminal &) = delete;
+
+    // One screen, a line per entry. Lines should fit the terminal's width,
+    // a wrapped line pushes the ones below it out of place.
+    void draw(const std::vector<std::string> &lines);
+    // Blank screen with the cursor back, for plain output; the next draw()
+    // starts over
+    void clear();
+
+    // Waits up to timeoutMs (forever if negative) for a key. False on
+    // timeout, or for good once input has ended (see closed()). Piped
+    // input on Windows is read a line at a time and ignores the timeout.
+    bool readKey(char &key, int timeoutMs);
+    bool closed() const { return m_closed; }
+    // Drops keys typed but not read yet, e.g. at the console while the
+    // game window had the match. Pipes and files are left alone.
+    void discardInput();
+
+private:
+    std::vector<std::string> m_shown;
+    bool m_fresh;     // nothing of ours on screen, draw() clears it first
+    bool m_closed;
+#ifdef _WIN32
+    unsigned long m_outputMode;
+    bool m_console;   // stdin is a console rather than a pipe or file
+#endif
+};
+
+#endif // TERMINAL_H
@@ -0,0 +1,137 @@
+#include "toastoverlay.h"
+#include <QFontMetrics>
+#include <algorithm>
+
+namespace {
+const int PADDING = 10;
+const int BANNER_PADDING = 20;
+const int GAP = 8;               // between stacked toasts and above the bottom edge
+const int MAX_TEXT_WIDTH = 420;
+const int TEXT_FLAGS = Qt::AlignCenter | Qt::TextWordWrap;
+}
+
+ToastOverlay::ToastOverlay()
+    : m_changed(false) {
+    m_clock.start();
+}
+
+void ToastOverlay::post(const QString &text) {
+    if (m_toasts.size() >= MAX_TOASTS) {
+        m_toasts.erase(m_toasts.begin());
+    }
+    m_toasts.push_back(Toast{text, m_clock.elapsed()});
+    m_changed = true;
+}
+
+void ToastOverlay::setBanner(const QString &title, const QString &text) {
+    m_bannerTitle = title;
+    m_bannerText = text;
+    m_changed = true;
+}
+
+void ToastOverlay::clear() {
+    m_toasts.clear();
+    m_bannerTitle.clear();
+    m_bannerText.clear();
+    m_changed = true;
+}
+
+QRect ToastOverlay::advance(const QSize &view) {
+    const qint64 now = m_clock.elapsed();
+    const size_t before = m_toasts.size();
+    m_toasts.erase(std::remove_if(m_toasts.begin(), m_toasts.end(),
+                                  [now](const Toast &t) { return now - t.postedMs >= TOAST_MS; }),
+                   m_toasts.end());
+    m_changed = m_changed || m_toasts.size() != before;
+
+    QRect covered = bannerRect(view);
+    bool fading = false;
+    for (size_t i = 0; i < m_toasts.size(); i++) {
+        covered |= toastRect(i, view);
+        fading = fading || toastOpacity(i, now) < 1;
+    }
+
+    QRect dirty;
+    if (m_changed || fading) {
+        dirty = covered | m_shown;
+    }
+    m_shown = covered;
+    m_changed = false;
+    return dirty;
+}
+
+void ToastOverlay::paint(QPainter &p, const QSize &view) const {
+    const qint64 now = m_clock.elapsed();
+    p.save();
+    p.setRenderHint(QPainter::Antialiasing);
+
+    for (size_t i = 0; i < m_toasts.size(); i++) {
+        const QRect r = toastRect(i, view);
+        p.setOpacity(toastOpacity(i, now));
+        p.setPen(Qt::NoPen);
+        p.setBrush(QColor(0, 0, 0, 200));
+        p.drawRoundedRect(r, 6, 6);
+        p.setPen(Qt::white);
+        p.setFont(m_font);
+        p.drawText(r.adjusted(PADDING, PADDING, -PADDING, -PADDING), TEXT_FLAGS, m_toasts[i].text);
+    }
+
+    const QRect banner = bannerRect(view);
+    if (!banner.isEmpty()) {
+        p.setOpacity(1);
+        p.setPen(QPen(Qt::darkGray, 2));
+        p.setBrush(QColor(255, 255, 255, 235));
+        p.drawRoundedRect(banner, 10, 10);
+
+        const QRect inner = banner.adjusted(BANNER_PADDING, BANNER_PADDING, -BANNER_PADDING, -BANNER_PADDING);
+        const int titleHeight = QFontMetrics(titleFont()).height();
+        p.setPen(Qt::black);
+        p.setFont(titleFont());
+        p.drawText(QRect(inner.left(), inner.top(), inner.width(), titleHeight), TEXT_FLAGS, m_bannerTitle);
+        p.setFont(m_font);
+        p.drawText(inner.adjusted(0, titleHeight + GAP, 0, 0), TEXT_FLAGS, m_bannerText);
+    }
+    p.restore();
+}
+
+QFont ToastOverlay::titleFont() const {
+    QFont font = m_font;
+    font.setPointSizeF(font.pointSizeF() * 1.6);
+    font.setBold(true);
+    return font;
+}
+
+int ToastOverlay::textWidth(const QSize &view) const {
+    return std::max(1, std::min(view.width() - 2 * (BANNER_PADDING + GAP), MAX_TEXT_WIDTH));
+}
+
+QRect ToastOverlay::bannerRect(const QSize &view) const {
+    if (m_bannerTitle.isEmpty() && m_bannerText.isEmpty()) {
+        return QRect();
+    }
+    const int width = textWidth(view);
+    const QRect text = QFontMetrics(m_font).boundingRect(QRect(0, 0, width, 0), TEXT_FLAGS, m_bannerText);
+    const int height = QFontMetrics(titleFont()).height() + GAP + text.height() + 2 * BANNER_PADDING;
+    const int outerWidth = width + 2 * BANNER_PADDING;
+    return QRect((view.width() - outerWidth) / 2, (view.height() - height) / 2, outerWidth, height);
+}
+
+QRect ToastOverlay::toastRect(size_t i, const QSize &view) const {
+    // Newest at the bottom, older ones pushed up above it
+    const QFontMetrics metrics(m_font);
+    int bottom = view.height() - GAP;
+    QRect r;
+    for (size_t j = m_toasts.size(); j-- > i;) {
+        const QRect text = metrics.boundingRect(QRect(0, 0, textWidth(view), 0), TEXT_FLAGS, m_toasts[j].text);
+        const int width = text.width() + 2 * PADDING;
+        const int height = text.height() + 2 * PADDING;
+        r = QRect((view.width() - width) / 2, bottom - height, width, height);
+        bottom = r.top() - GAP;
+    }
+    return r;
+}
+
+qreal ToastOverlay::toastOpacity(size_t i, qint64 now) const {
+    const qint64 left = TOAST_MS - (now - m_toasts[i].postedMs);
+    return left >= FADE_MS ? 1.0 : std::max<qreal>(0, static_cast<qreal>(left) / FADE_MS);
+}
@@ -0,0 +1,57 @@
+#ifndef TOASTOVERLAY_H
+#define TOASTOVERLAY_H
+
+#include <QElapsedTimer>
+#include <QFont>
+#include <QPainter>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <vector>
+
+// Messages drawn on top of the game view in place of modal dialogs, so
+// nothing ever waits on the player to dismiss one. Toasts stack up at the
+// bottom and fade out on their own; the banner is a larger panel in the
+// middle that stays up.
+class ToastOverlay {
+public:
+    static const int TOAST_MS = 3000;
+    static const int FADE_MS = 400;
+    static const int MAX_TOASTS = 4;
+
+    ToastOverlay();
+
+    void setFont(const QFont &font) { m_font = font; }
+    void post(const QString &text);
+    void setBanner(const QString &title, const QString &text);
+    // Toasts and banner both
+    void clear();
+
+    // Drops toasts that have run out. Returns the part of a view of the
+    // given size to repaint since the last call, empty if nothing changed.
+    QRect advance(const QSize &view);
+    // In widget pixels, without any arena transform
+    void paint(QPainter &p, const QSize &view) const;
+
+private:
+    struct Toast {
+        QString text;
+        qint64 postedMs;
+    };
+
+    QFont m_font;
+    QElapsedTimer m_clock;
+    std::vector<Toast> m_toasts;  // oldest first
+    QString m_bannerTitle;
+    QString m_bannerText;
+    QRect m_shown;    // area covered at the last advance()
+    bool m_changed;
+
+    QFont titleFont() const;
+    int textWidth(const QSize &view) const;
+    QRect bannerRect(const QSize &view) const;
+    QRect toastRect(size_t i, const QSize &view) const;
+    qreal toastOpacity(size_t i, qint64 now) const;
+};
+
+#endif // TOASTOVERLAY_H
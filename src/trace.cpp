@@ -0,0 +1,124 @@
+#include "trace.h"
+
+#ifdef GAME_TRACE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const char *PHASE_NAMES[] = {
+    "tick", "spawn", "line health", "movement", "dog collision",
+    "line collision", "culling", "win check", "paint"
+};
+
+struct Event {
+    uint64_t start;     // ns since the first event
+    uint32_t duration;  // ns
+    uint16_t phase;
+    uint16_t thread;
+};
+
+// Writers claim slots with one atomic add, so any thread may record
+// without locking; the oldest events get overwritten.
+const size_t RING_SIZE = 1 << 16;
+Event ring[RING_SIZE];
+std::atomic<uint64_t> ringNext(0);
+
+std::atomic<uint16_t> threadCount(0);
+thread_local uint16_t threadId = threadCount.fetch_add(1, std::memory_order_relaxed);
+
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+} // namespace
+
+namespace trace {
+
+uint64_t now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+void record(TracePhase phase, uint64_t start, uint64_t duration) {
+    const uint64_t slot = ringNext.fetch_add(1, std::memory_order_relaxed) & (RING_SIZE - 1);
+    Event &e = ring[slot];
+    e.start = start;
+    e.duration = static_cast<uint32_t>(std::min<uint64_t>(duration, UINT32_MAX));
+    e.phase = static_cast<uint16_t>(phase);
+    e.thread = threadId;
+}
+
+Splitter::Splitter() : m_start(now()), m_current(-1), m_total() {
+    m_mark = m_start;
+}
+
+void Splitter::enter(TracePhase phase) {
+    const uint64_t t = now();
+    if (m_current >= 0) {
+        m_total[m_current] += t - m_mark;
+    }
+    m_current = static_cast<int>(phase);
+    m_mark = t;
+}
+
+void Splitter::leave() {
+    if (m_current >= 0) {
+        m_total[m_current] += now() - m_mark;
+        m_current = -1;
+    }
+}
+
+Splitter::~Splitter() {
+    leave();
+    for (int p = 0; p < static_cast<int>(TracePhase::Count); p++) {
+        if (m_total[p]) {
+            record(static_cast<TracePhase>(p), m_start, m_total[p]);
+        }
+    }
+}
+
+} // namespace trace
+
+void traceDump(const char *jsonPath) {
+    const uint64_t written = ringNext.load(std::memory_order_acquire);
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(written, RING_SIZE));
+    std::vector<Event> events(count);
+    for (size_t i = 0; i < count; i++) {
+        events[i] = ring[(written - count + i) & (RING_SIZE - 1)];
+    }
+
+    FILE *json = fopen(jsonPath, "w");
+    if (json) {
+        fprintf(json, "{\"traceEvents\":[\n");
+        for (size_t i = 0; i < count; i++) {
+            const Event &e = events[i];
+            fprintf(json, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    i ? ",\n" : "", PHASE_NAMES[e.phase], static_cast<unsigned>(e.thread),
+                    e.start / 1000.0, e.duration / 1000.0);
+        }
+        fprintf(json, "\n]}\n");
+        fclose(json);
+    }
+
+    printf("Trace: %zu events%s, written to %s\n", count,
+           written > count ? " (oldest dropped)" : "", json ? jsonPath : "nowhere");
+    printf("  %-16s %8s %10s %10s %10s\n", "phase", "count", "p50 us", "p99 us", "max us");
+    for (int p = 0; p < static_cast<int>(TracePhase::Count); p++) {
+        std::vector<uint32_t> durations;
+        for (const Event &e : events) {
+            if (e.phase == p) durations.push_back(e.duration);
+        }
+        if (durations.empty()) {
+            continue;
+        }
+        std::sort(durations.begin(), durations.end());
+        auto at = [&](double q) { return durations[static_cast<size_t>(q * (durations.size() - 1))] / 1000.0; };
+        printf("  %-16s %8zu %10.1f %10.1f %10.1f\n", PHASE_NAMES[p], durations.size(),
+               at(0.5), at(0.99), at(1.0));
+    }
+}
+
+#endif
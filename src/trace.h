@@ -0,0 +1,80 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Per-phase timing of game ticks and paints. Build with CONFIG+=trace to
+// turn it on (defines GAME_TRACE); otherwise every macro below compiles to
+// nothing. Events go into a fixed ring buffer that keeps the most recent
+// ones; traceDump() writes them as Chrome trace_event JSON (load it in
+// chrome://tracing or ui.perfetto.dev) and prints p50/p99/max per phase.
+
+enum class TracePhase {
+    Tick,
+    Spawn,
+    LineHealth,
+    Movement,
+    DogCollision,
+    LineCollision,
+    Culling,
+    WinCheck,
+    Paint,
+    Count
+};
+
+#ifdef GAME_TRACE
+
+#include <cstdint>
+
+namespace trace {
+
+uint64_t now();
+void record(TracePhase phase, uint64_t start, uint64_t duration);
+
+class Scope {
+public:
+    explicit Scope(TracePhase phase) : m_phase(phase), m_start(now()) {}
+    ~Scope() { record(m_phase, m_start, now() - m_start); }
+private:
+    TracePhase m_phase;
+    uint64_t m_start;
+};
+
+// Times phases that take turns inside one loop. Time between enter() calls
+// goes to the phase entered last; each phase becomes one event with the
+// summed time when the splitter goes out of scope.
+class Splitter {
+public:
+    Splitter();
+    ~Splitter();
+    void enter(TracePhase phase);
+    void leave();
+private:
+    uint64_t m_start;
+    uint64_t m_mark;
+    int m_current;
+    uint64_t m_total[static_cast<int>(TracePhase::Count)];
+};
+
+} // namespace trace
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(phase) trace::Scope TRACE_CONCAT(traceScope, __LINE__)(phase)
+#define TRACE_SPLITTER(name) trace::Splitter name
+#define TRACE_ENTER(name, phase) name.enter(phase)
+#define TRACE_LEAVE(name) name.leave()
+
+// Writes the buffered events to jsonPath and the summary to stdout
+void traceDump(const char *jsonPath);
+
+#else
+
+#define TRACE_SCOPE(phase) ((void)0)
+#define TRACE_SPLITTER(name) ((void)0)
+#define TRACE_ENTER(name, phase) ((void)0)
+#define TRACE_LEAVE(name) ((void)0)
+
+inline void traceDump(const char *) {}
+
+#endif
+
+#endif // TRACE_H
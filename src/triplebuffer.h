@@ -0,0 +1,43 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Hands the newest value from one writer thread to one reader thread without
+// either side waiting. The writer fills back() and publishes it; the reader
+// picks up whatever was published last. Each side has a slot of its own and
+// the third one changes hands, so the reader's front() stays untouched until
+// its next acquire(). Values published in between are skipped.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side
+    T &back() { return m_slots[m_back]; }
+    void publish() {
+        const unsigned char old = m_spare.exchange(static_cast<unsigned char>(m_back | FRESH),
+                                                   std::memory_order_acq_rel);
+        m_back = old & INDEX;
+    }
+
+    // Reader side. True when a newer value was taken over.
+    bool acquire() {
+        if (!(m_spare.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        const unsigned char old = m_spare.exchange(m_front, std::memory_order_acq_rel);
+        m_front = old & INDEX;
+        return true;
+    }
+    const T &front() const { return m_slots[m_front]; }
+
+private:
+    static const unsigned char INDEX = 3;
+    static const unsigned char FRESH = 4;  // spare slot holds an unread value
+
+    T m_slots[3];
+    unsigned char m_back = 0;
+    unsigned char m_front = 1;
+    std::atomic<unsigned char> m_spare{2};
+};
+
+#endif // TRIPLEBUFFER_H
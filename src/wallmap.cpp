@@ -0,0 +1,121 @@
+#include "wallmap.h"
+#include <cstdlib>
+#include <numeric>
+
+namespace {
+
+// Reduces (dx, dy) to the step between neighbouring lattice points on the
+// line; returns how many such steps the line takes
+int primitiveStep(int dx, int dy, int &sx, int &sy) {
+    const int n = std::gcd(std::abs(dx), std::abs(dy));
+    if (n == 0) {
+        sx = sy = 0;
+        return 0;
+    }
+    sx = dx / n;
+    sy = dy / n;
+    return n;
+}
+
+// Hash key of a link in one of the directions without a bitmap
+uint64_t otherKey(int node, int sx, int sy) {
+    return static_cast<uint64_t>(node) << 32 |
+           static_cast<uint64_t>(static_cast<uint16_t>(sx)) << 16 |
+           static_cast<uint16_t>(sy);
+}
+
+} // namespace
+
+void WallMap::reset(int cols, int rows) {
+    m_cols = cols;
+    m_rows = rows;
+    m_bits.assign((static_cast<size_t>(cols) * rows * 4 + 63) / 64, 0);
+    m_other.clear();
+}
+
+bool WallMap::linkBit(int x, int y, int sx, int sy, size_t &bit) const {
+    int dir;
+    if (sy == 0) {
+        dir = 0;                 // east
+    } else if (sx == 0) {
+        dir = 1;                 // south
+    } else if (sx == 1 && sy == 1) {
+        dir = 2;                 // south-east
+    } else if (sx == -1 && sy == 1) {
+        dir = 3;                 // south-west
+    } else {
+        return false;
+    }
+    bit = static_cast<size_t>(y * m_cols + x) * 4 + dir;
+    return true;
+}
+
+// Links are stored from whichever end makes the step point south, or east
+// along a row, so both ways along a line find the same entry
+bool WallMap::test(int x, int y, int sx, int sy) const {
+    if (sy < 0 || (sy == 0 && sx < 0)) {
+        x += sx;
+        y += sy;
+        sx = -sx;
+        sy = -sy;
+    }
+    size_t bit;
+    if (linkBit(x, y, sx, sy, bit)) {
+        return (m_bits[bit / 64] >> (bit % 64)) & 1;
+    }
+    return m_other.count(otherKey(y * m_cols + x, sx, sy)) != 0;
+}
+
+void WallMap::set(int x, int y, int sx, int sy, bool on) {
+    if (sy < 0 || (sy == 0 && sx < 0)) {
+        x += sx;
+        y += sy;
+        sx = -sx;
+        sy = -sy;
+    }
+    size_t bit;
+    if (linkBit(x, y, sx, sy, bit)) {
+        const uint64_t mask = uint64_t(1) << (bit % 64);
+        m_bits[bit / 64] = on ? m_bits[bit / 64] | mask : m_bits[bit / 64] & ~mask;
+    } else if (on) {
+        m_other.insert(otherKey(y * m_cols + x, sx, sy));
+    } else {
+        m_other.erase(otherKey(y * m_cols + x, sx, sy));
+    }
+}
+
+void WallMap::mark(int ax, int ay, int bx, int by, bool on) {
+    int sx, sy;
+    const int n = primitiveStep(bx - ax, by - ay, sx, sy);
+    for (int i = 0; i < n; i++) {
+        set(ax + i * sx, ay + i * sy, sx, sy, on);
+    }
+}
+
+void WallMap::add(int ax, int ay, int bx, int by) {
+    mark(ax, ay, bx, by, true);
+}
+
+void WallMap::remove(int ax, int ay, int bx, int by) {
+    mark(ax, ay, bx, by, false);
+}
+
+bool WallMap::walled(int fromX, int fromY, int toX, int toY) const {
+    return test(fromX, fromY, toX - fromX, toY - fromY);
+}
+
+void WallMap::openRuns(int ax, int ay, int bx, int by, std::vector<WallRun> &runs) const {
+    runs.clear();
+    int sx, sy;
+    const int n = primitiveStep(bx - ax, by - ay, sx, sy);
+    int start = -1;   // first link of the open run being collected
+    for (int i = 0; i <= n; i++) {
+        const bool open = i < n && !test(ax + i * sx, ay + i * sy, sx, sy);
+        if (open && start < 0) {
+            start = i;
+        } else if (!open && start >= 0) {
+            runs.push_back(WallRun{ax + start * sx, ay + start * sy, ax + i * sx, ay + i * sy});
+            start = -1;
+        }
+    }
+}
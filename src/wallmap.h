@@ -0,0 +1,50 @@
+#ifndef WALLMAP_H
+#define WALLMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+// Part of a line, by its lattice endpoints
+struct WallRun {
+    int ax;
+    int ay;
+    int bx;
+    int by;
+};
+
+// Which lattice links are walled. A line from a to b passes through the
+// lattice points a, a+s, a+2s, ... b, where s is b-a reduced to lowest
+// terms; each step from one of them to the next is a link. Links along the
+// grid lines and diagonals, which walls are mostly made of, are one bit each
+// in a packed bitmap (four per lattice point); links in any other direction
+// are kept in a hash set. Walls must not share links, so a link is either
+// walled by exactly one wall or open.
+class WallMap {
+public:
+    void reset(int cols, int rows);
+
+    // Marks or clears every link of the line from a to b
+    void add(int ax, int ay, int bx, int by);
+    void remove(int ax, int ay, int bx, int by);
+
+    // One link: to - from must be a direction in lowest terms
+    bool walled(int fromX, int fromY, int toX, int toY) const;
+    // The stretches of the line from a to b that are not walled yet, from
+    // a's end. Empty if all of it is, or if a and b are the same point.
+    void openRuns(int ax, int ay, int bx, int by, std::vector<WallRun> &runs) const;
+
+private:
+    int m_cols = 0;
+    int m_rows = 0;
+    std::vector<uint64_t> m_bits;       // node*4 + direction, see linkBit()
+    std::unordered_set<uint64_t> m_other;
+
+    bool linkBit(int x, int y, int sx, int sy, size_t &bit) const;
+    bool test(int x, int y, int sx, int sy) const;
+    void set(int x, int y, int sx, int sy, bool on);
+    void mark(int ax, int ay, int bx, int by, bool on);
+};
+
+#endif // WALLMAP_H